@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#include <string.h>
+
+#include "callgraph.h"
+#include "client.h"
+#include "disasm.h"
+#include "trace.h"
+
+#define INTERRUPT_DISPATCH_CYCLES 20
+
+static struct {
+	struct callgraph_node nodes[CALLGRAPH_MAX_NODES];
+	int num_nodes;
+	int stack[CALLGRAPH_MAX_DEPTH];
+	int depth;
+	int dropped; // calls past CALLGRAPH_MAX_DEPTH, charged to the deepest routine kept
+} cg;
+
+static int new_node(uint32_t addr, bool is_interrupt, int parent) {
+	if (cg.num_nodes == CALLGRAPH_MAX_NODES)
+		return -1;
+
+	int idx = cg.num_nodes++;
+	cg.nodes[idx] = (struct callgraph_node){
+		.addr = addr,
+		.is_interrupt = is_interrupt,
+		.parent = parent,
+		.first_child = -1,
+		.next_sibling = -1,
+	};
+	if (parent != -1) {
+		cg.nodes[idx].next_sibling = cg.nodes[parent].first_child;
+		cg.nodes[parent].first_child = idx;
+	}
+	return idx;
+}
+
+static void enter(uint32_t addr, bool is_interrupt) {
+	if (cg.depth == CALLGRAPH_MAX_DEPTH) {
+		cg.dropped++;
+		return;
+	}
+
+	int curr = cg.stack[cg.depth-1];
+	int child = cg.nodes[curr].first_child;
+	while (child != -1 && cg.nodes[child].addr != addr)
+		child = cg.nodes[child].next_sibling;
+	if (child == -1)
+		child = new_node(addr, is_interrupt, curr);
+	// out of nodes; keep charging the caller, but stay balanced with the returns
+	if (child == -1)
+		child = curr;
+
+	cg.nodes[child].calls++;
+	if (is_interrupt)
+		cg.nodes[child].excl_cycles += INTERRUPT_DISPATCH_CYCLES;
+	cg.stack[cg.depth++] = child;
+}
+
+static void leave() {
+	// the returns of the dropped calls come first, and have nothing to pop
+	if (cg.dropped)
+		cg.dropped--;
+	// returning from the routine the trace started in doesn't tell us who called it
+	else if (cg.depth > 1)
+		cg.depth--;
+}
+
+static bool is_interrupt_vector(uint32_t addr) {
+	return addr >= 0x40 && addr <= 0x60 && !(addr & 7);
+}
+
+// replay the trace, following calls, rsts, returns and interrupt entries to keep a shadow
+// call stack. every instruction is charged to the routine on top of it.
+int callgraph_build() {
+	cg.num_nodes = 0;
+	cg.depth = 0;
+	cg.dropped = 0;
+
+	size_t num_records = trace_get_count();
+	if (!num_records)
+		return 0;
+
+	cg.stack[cg.depth++] = new_node(trace_get(0)->pc, false, -1);
+
+	for (size_t i = 0; i < num_records; i++) {
+		const struct trace_record *rec = trace_get(i);
+		uint16_t pc = ADDR_OFFSET(rec->pc);
+		uint32_t fallthrough = (uint16_t)(pc + disasm_op_len(rec->bytes[0]));
+		uint32_t target = 0;
+		enum disasm_flow flow = disasm_op_flow(rec->bytes, pc, &target);
+
+		// the flow is followed by plain addresses, while nodes are keyed by the banked pc
+		// that was recorded, so the same address in two banks makes two routines
+		bool has_next = i+1 < num_records;
+		uint32_t next = has_next ? trace_get(i+1)->pc : fallthrough;
+		bool taken = ADDR_OFFSET(next) != fallthrough;
+
+		cg.nodes[cg.stack[cg.depth-1]].excl_cycles += disasm_op_cycles(rec->bytes, taken);
+		if (!taken)
+			continue;
+
+		switch (flow) {
+			case FLOW_CALL:
+			case FLOW_CALL_COND:
+			case FLOW_RST:
+				if (ADDR_OFFSET(next) == target)
+					enter(next, false);
+				else if (is_interrupt_vector(next))
+					enter(next, true);
+				break;
+			case FLOW_RET:
+			case FLOW_RET_COND:
+			case FLOW_RETI:
+				leave();
+				break;
+			case FLOW_JUMP_INDIRECT:
+				break;
+			case FLOW_JUMP:
+			case FLOW_JUMP_COND:
+				if (ADDR_OFFSET(next) != target && is_interrupt_vector(next))
+					enter(next, true);
+				break;
+			default:
+				if (is_interrupt_vector(next))
+					enter(next, true);
+				break;
+		}
+	}
+
+	// children are always created after their parents, so a reverse walk is a post-order one
+	for (int i = cg.num_nodes-1; i >= 0; i--) {
+		struct callgraph_node *node = &cg.nodes[i];
+		node->incl_cycles += node->excl_cycles;
+		if (node->parent != -1)
+			cg.nodes[node->parent].incl_cycles += node->incl_cycles;
+	}
+
+	return cg.num_nodes;
+}
+
+int callgraph_get_num_nodes() {
+	return cg.num_nodes;
+}
+
+const struct callgraph_node *callgraph_get_node(int idx) {
+	return &cg.nodes[idx];
+}
+
+static uint64_t sort_key(int idx, enum callgraph_sort key) {
+	return key == CALLGRAPH_SORT_INCL ? cg.nodes[idx].incl_cycles : cg.nodes[idx].excl_cycles;
+}
+
+// order the children of every node, most expensive first
+void callgraph_sort(enum callgraph_sort key) {
+	for (int i = 0; i < cg.num_nodes; i++) {
+		int sorted = -1;
+		int child = cg.nodes[i].first_child;
+		while (child != -1) {
+			int next = cg.nodes[child].next_sibling;
+			int *link = &sorted;
+			while (*link != -1 && sort_key(*link, key) >= sort_key(child, key))
+				link = &cg.nodes[*link].next_sibling;
+			cg.nodes[child].next_sibling = *link;
+			*link = child;
+			child = next;
+		}
+		cg.nodes[i].first_child = sorted;
+	}
+}
+
+// one line per call path with its exclusive cycles, as taken by flamegraph.pl and friends
+int callgraph_export_folded(FILE *f) {
+	for (int i = 0; i < cg.num_nodes; i++) {
+		if (!cg.nodes[i].excl_cycles)
+			continue;
+
+		int path[CALLGRAPH_MAX_DEPTH+1];
+		int len = 0;
+		for (int n = i; n != -1; n = cg.nodes[n].parent)
+			path[len++] = n;
+		while (len--) {
+			const struct callgraph_node *node = &cg.nodes[path[len]];
+			if (node->is_interrupt)
+				fprintf(f, "int_%04x", node->addr);
+			else if (ADDR_IS_BANKED(node->addr))
+				fprintf(f, "%02x:%04x", ADDR_BANK(node->addr), ADDR_OFFSET(node->addr));
+			else
+				fprintf(f, "0x%04x", node->addr);
+			if (len)
+				fputc(';', f);
+		}
+		if (fprintf(f, " %llu\n", (unsigned long long)cg.nodes[i].excl_cycles) < 0)
+			return -1;
+	}
+	return 0;
+}
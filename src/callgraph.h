@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define CALLGRAPH_MAX_NODES 4096
+#define CALLGRAPH_MAX_DEPTH 256
+
+// a node is a routine in the context of its callers, so the same routine called from two
+// places has two nodes
+struct callgraph_node {
+	uint32_t addr;
+	bool is_interrupt;
+	int parent, first_child, next_sibling;
+	uint32_t calls;
+	uint64_t incl_cycles, excl_cycles;
+};
+
+enum callgraph_sort {
+	CALLGRAPH_SORT_INCL,
+	CALLGRAPH_SORT_EXCL,
+};
+
+int callgraph_build();
+int callgraph_get_num_nodes();
+const struct callgraph_node *callgraph_get_node(int idx);
+void callgraph_sort(enum callgraph_sort key);
+int callgraph_export_folded(FILE *f);
+
+#endif
@@ -0,0 +1,718 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "client.h"
+
+#define CFG_RAM_START 0x8000
+#define CFG_WORKLIST_SIZE 1024
+
+// a part of the address space with its own copy of the memory: rom bank 0, each switchable
+// rom bank as it gets mapped, and ram
+struct cfg_region {
+	uint32_t base, size;
+	uint32_t bank;
+	bool valid;
+	// index+1 of the block holding the instruction that starts at each address, 0 if none
+	uint16_t *block_of;
+	uint8_t *mem; // padded so the last instruction can be decoded
+};
+
+// the graph is built incrementally as code is discovered and kept across stops. rom doesn't
+// change under us, so only what was found in ram is thrown away.
+static struct {
+	struct cfg_region *bank0, *ram;
+	struct cfg_region *banks[CFG_MAX_BANKS];
+	uint32_t curr_bank;
+
+	struct cfg_block blocks[CFG_MAX_BLOCKS];
+	int num_blocks;
+
+	// references to each address are chained from xref_head through cfg_xref.next
+	struct cfg_xref xrefs[CFG_MAX_XREFS];
+	int num_xrefs;
+	int xref_head[0x10000];
+
+	// bumped whenever rom blocks are added or split, for the on-disk cache
+	uint32_t rom_generation;
+} cfg = { .curr_bank = 1 };
+
+static struct cfg_region *new_region(uint32_t base, uint32_t size, uint32_t bank) {
+	struct cfg_region *region = calloc(1, sizeof(*region));
+	if (!region) {
+		perror("calloc()");
+		return NULL;
+	}
+	region->base = base;
+	region->size = size;
+	region->bank = bank;
+	region->block_of = calloc(size, sizeof(*region->block_of));
+	region->mem = calloc(1, size+2);
+	if (!region->block_of || !region->mem) {
+		perror("calloc()");
+		free(region->block_of);
+		free(region->mem);
+		free(region);
+		return NULL;
+	}
+	return region;
+}
+
+// the region of `addr`, with its memory loaded. a banked address picks its switchable bank,
+// any other one the bank that is mapped.
+static struct cfg_region *get_region(uint32_t addr) {
+	uint32_t offset = ADDR_OFFSET(addr);
+	uint32_t bank = ADDR_IS_BANKED(addr) ? ADDR_BANK(addr) : cfg.curr_bank;
+	struct cfg_region **region;
+	if (offset < ROM_BANK_SIZE)
+		region = &cfg.bank0;
+	else if (offset < CFG_RAM_START)
+		region = &cfg.banks[bank % CFG_MAX_BANKS];
+	else
+		region = &cfg.ram;
+
+	if (!*region) {
+		if (offset < ROM_BANK_SIZE)
+			*region = new_region(0, ROM_BANK_SIZE, 0);
+		else if (offset < CFG_RAM_START)
+			*region = new_region(ROM_BANK_SIZE, ROM_BANK_SIZE, bank);
+		else
+			*region = new_region(CFG_RAM_START, 0x10000-CFG_RAM_START, CFG_BANK_RAM);
+		if (!*region)
+			return NULL;
+	}
+	if (!(*region)->valid) {
+		// a switchable bank is read whole, whether it's mapped or not
+		int ret = (*region)->base == ROM_BANK_SIZE ?
+			client_read_rom_bank((*region)->bank, (*region)->mem) :
+			client_read_mem((*region)->base, (*region)->size, (*region)->mem);
+		if (ret == -1)
+			return NULL;
+		(*region)->valid = true;
+	}
+	return *region;
+}
+
+static int block_idx(uint32_t addr) {
+	struct cfg_region *region = get_region(addr);
+	return region ? region->block_of[ADDR_OFFSET(addr) - region->base]-1 : -1;
+}
+
+// `addr` as reached from code in `bank`: jumps and calls from a switchable bank into the
+// switchable area stay in that bank, the rest go wherever is mapped
+static uint32_t in_bank(uint32_t bank, uint32_t addr) {
+	addr = ADDR_OFFSET(addr);
+	if (bank != 0 && bank != CFG_BANK_RAM && ADDR_IS_SWITCHABLE(addr))
+		return ADDR_BANKED(bank, addr);
+	return addr;
+}
+
+static void add_xref(uint32_t bank, uint32_t from, uint32_t to, enum cfg_xref_kind kind) {
+	if (cfg.num_xrefs == CFG_MAX_XREFS)
+		return;
+
+	to &= 0xffff;
+	cfg.xrefs[cfg.num_xrefs] = (struct cfg_xref){
+		.bank = bank,
+		.from = from,
+		.to = to,
+		.kind = kind,
+		.next = cfg.xref_head[to],
+	};
+	cfg.xref_head[to] = ++cfg.num_xrefs;
+}
+
+static void index_instr(uint32_t bank, uint32_t addr, const uint8_t *bytes, enum disasm_flow flow,
+		uint32_t target) {
+	uint32_t imm16 = bytes[1] | (bytes[2] << 8);
+
+	switch (flow) {
+		case FLOW_JUMP:
+		case FLOW_JUMP_COND:
+			add_xref(bank, addr, target, XREF_JUMP);
+			return;
+		case FLOW_CALL:
+		case FLOW_CALL_COND:
+		case FLOW_RST:
+			add_xref(bank, addr, target, XREF_CALL);
+			return;
+		default:
+			break;
+	}
+	switch (bytes[0]) {
+		case 0x08: case 0xea:
+			add_xref(bank, addr, imm16, XREF_WRITE);
+			break;
+		case 0xfa:
+			add_xref(bank, addr, imm16, XREF_READ);
+			break;
+		case 0xe0:
+			add_xref(bank, addr, 0xff00 | bytes[1], XREF_WRITE);
+			break;
+		case 0xf0:
+			add_xref(bank, addr, 0xff00 | bytes[1], XREF_READ);
+			break;
+		case 0x01: case 0x11: case 0x21: case 0x31:
+			add_xref(bank, addr, imm16, XREF_IMM);
+			break;
+	}
+}
+
+// walk the block from its start up to `end`, or, if `end` is 0, up to its first control
+// transfer or the start of another block. blocks never cross regions.
+static void decode_block(struct cfg_region *region, int idx, uint32_t end) {
+	struct cfg_block *blk = &cfg.blocks[idx];
+	uint32_t addr = blk->start, last_cycles = 0, last_cycles_taken = 0;
+
+	blk->bank = region->bank;
+	blk->num_instrs = 0;
+	blk->cycles = 0;
+	blk->target = 0;
+	for (;;) {
+		uint32_t offset = addr - region->base;
+		const uint8_t *bytes = &region->mem[offset];
+		blk->last = addr;
+		blk->num_instrs++;
+		blk->flow = disasm_op_flow(bytes, addr, &blk->target);
+		last_cycles = disasm_op_cycles(bytes, false);
+		last_cycles_taken = disasm_op_cycles(bytes, true);
+		blk->cycles += last_cycles;
+		// instructions seen for the first time go into the cross-reference index
+		if (!region->block_of[offset])
+			index_instr(region->bank, addr, bytes, blk->flow, blk->target);
+		region->block_of[offset] = idx+1;
+
+		addr += disasm_op_len(bytes[0]);
+		if (addr >= region->base + region->size)
+			break;
+		if (end ? addr >= end : (blk->flow != FLOW_NONE || region->block_of[addr - region->base]))
+			break;
+	}
+	blk->end = addr;
+	blk->cycles_taken = blk->cycles - last_cycles + last_cycles_taken;
+	if (region->bank != CFG_BANK_RAM)
+		cfg.rom_generation++;
+}
+
+static void split_block(struct cfg_region *region, int idx, uint32_t addr) {
+	if (cfg.num_blocks == CFG_MAX_BLOCKS)
+		return;
+
+	int tail = cfg.num_blocks++;
+	cfg.blocks[tail].start = addr;
+	decode_block(region, tail, cfg.blocks[idx].end);
+	decode_block(region, idx, addr);
+}
+
+static bool falls_through(enum disasm_flow flow) {
+	return flow != FLOW_JUMP && flow != FLOW_JUMP_INDIRECT && flow != FLOW_RET &&
+		flow != FLOW_RETI;
+}
+
+static bool has_target(enum disasm_flow flow) {
+	return flow == FLOW_JUMP || flow == FLOW_JUMP_COND || flow == FLOW_CALL ||
+		flow == FLOW_CALL_COND || flow == FLOW_RST;
+}
+
+// follow every jump and call reachable from `addr`, adding new blocks and splitting the
+// existing ones that turn out to be jumped into
+int cfg_explore(uint32_t addr) {
+	uint32_t worklist[CFG_WORKLIST_SIZE];
+	size_t num_work = 0;
+	worklist[num_work++] = ADDR_IS_BANKED(addr) ? addr : ADDR_OFFSET(addr);
+	while (num_work) {
+		addr = worklist[--num_work];
+		struct cfg_region *region = get_region(addr);
+		if (!region)
+			return -1;
+
+		uint32_t offset = ADDR_OFFSET(addr);
+		int idx = region->block_of[offset - region->base]-1;
+		if (idx >= 0) {
+			if (cfg.blocks[idx].start != offset)
+				split_block(region, idx, offset);
+			continue;
+		}
+		if (cfg.num_blocks == CFG_MAX_BLOCKS)
+			break;
+
+		idx = cfg.num_blocks++;
+		cfg.blocks[idx].start = offset;
+		decode_block(region, idx, 0);
+
+		const struct cfg_block *blk = &cfg.blocks[idx];
+		if (falls_through(blk->flow) && blk->end < 0x10000 && num_work < CFG_WORKLIST_SIZE)
+			worklist[num_work++] = in_bank(blk->bank, blk->end);
+		if (has_target(blk->flow) && num_work < CFG_WORKLIST_SIZE)
+			worklist[num_work++] = in_bank(blk->bank, blk->target);
+	}
+	return 0;
+}
+
+// the cartridge entry point, the rst vectors and the interrupt vectors
+int cfg_explore_entries() {
+	if (cfg_explore(0x100) == -1)
+		return -1;
+	for (uint32_t addr = 0; addr <= 0x60; addr += 8) {
+		if (cfg_explore(addr) == -1)
+			return -1;
+	}
+	return 0;
+}
+
+const struct cfg_block *cfg_get_block(uint32_t addr) {
+	int idx = block_idx(addr);
+	return idx >= 0 ? &cfg.blocks[idx] : NULL;
+}
+
+const uint8_t *cfg_get_mem(uint32_t addr) {
+	struct cfg_region *region = get_region(addr);
+	return region ? &region->mem[ADDR_OFFSET(addr) - region->base] : NULL;
+}
+
+bool cfg_is_leader(uint32_t addr) {
+	const struct cfg_block *blk = cfg_get_block(addr);
+	return blk && blk->start == ADDR_OFFSET(addr);
+}
+
+const struct cfg_xref *cfg_first_xref(uint32_t addr) {
+	int idx = cfg.xref_head[addr & 0xffff];
+	return idx ? &cfg.xrefs[idx-1] : NULL;
+}
+
+const struct cfg_xref *cfg_next_xref(const struct cfg_xref *xref) {
+	return xref->next ? &cfg.xrefs[xref->next-1] : NULL;
+}
+
+// the instruction making the reference, banked if it's in a switchable bank
+uint32_t cfg_xref_from(const struct cfg_xref *xref) {
+	return in_bank(xref->bank, xref->from);
+}
+
+void cfg_set_bank(uint32_t bank) {
+	cfg.curr_bank = bank;
+}
+
+// every instruction decoded from rom, bank by bank in no particular order
+void cfg_for_each_instr(void (*fn)(uint32_t bank, uint32_t addr, void *data), void *data) {
+	for (int i = 0; i < cfg.num_blocks; i++) {
+		const struct cfg_block *blk = &cfg.blocks[i];
+		if (blk->bank == CFG_BANK_RAM)
+			continue;
+		const struct cfg_region *region = blk->start < ROM_BANK_SIZE ?
+			cfg.bank0 : cfg.banks[blk->bank % CFG_MAX_BANKS];
+
+		uint32_t addr = blk->start;
+		while (addr < blk->end) {
+			fn(blk->bank, addr, data);
+			addr += disasm_op_len(region->mem[addr - region->base]);
+		}
+	}
+}
+
+static void reindex_block(int idx) {
+	const struct cfg_block *blk = &cfg.blocks[idx];
+	struct cfg_region *region = blk->start < ROM_BANK_SIZE ?
+		cfg.bank0 : cfg.banks[blk->bank % CFG_MAX_BANKS];
+
+	uint32_t addr = blk->start;
+	while (addr < blk->end) {
+		region->block_of[addr - region->base] = idx+1;
+		addr += disasm_op_len(region->mem[addr - region->base]);
+	}
+}
+
+uint32_t cfg_get_rom_generation() {
+	return cfg.rom_generation;
+}
+
+// the rom part of the graph as stored in the on-disk cache: a cfg_image_header, the blocks,
+// the references (their `next` links are rebuilt on load) and, for every rom region loaded,
+// its bank number followed by its memory. ram is left out since it may be rewritten.
+int cfg_write_image(FILE *f) {
+	struct cfg_image_header hdr = {};
+	struct cfg_region *regions[CFG_MAX_BANKS+1];
+	uint32_t num_regions = 0;
+	if (cfg.bank0 && cfg.bank0->valid)
+		regions[num_regions++] = cfg.bank0;
+	for (uint32_t i = 0; i < CFG_MAX_BANKS; i++) {
+		if (cfg.banks[i] && cfg.banks[i]->valid)
+			regions[num_regions++] = cfg.banks[i];
+	}
+	for (int i = 0; i < cfg.num_blocks; i++)
+		hdr.num_blocks += cfg.blocks[i].bank != CFG_BANK_RAM;
+	for (int i = 0; i < cfg.num_xrefs; i++)
+		hdr.num_xrefs += cfg.xrefs[i].bank != CFG_BANK_RAM;
+	hdr.num_regions = num_regions;
+
+	if (fwrite(&hdr, sizeof(hdr), 1, f) != 1)
+		return -1;
+	for (int i = 0; i < cfg.num_blocks; i++) {
+		if (cfg.blocks[i].bank != CFG_BANK_RAM && fwrite(&cfg.blocks[i], sizeof(*cfg.blocks), 1, f) != 1)
+			return -1;
+	}
+	for (int i = 0; i < cfg.num_xrefs; i++) {
+		if (cfg.xrefs[i].bank != CFG_BANK_RAM && fwrite(&cfg.xrefs[i], sizeof(*cfg.xrefs), 1, f) != 1)
+			return -1;
+	}
+	for (uint32_t i = 0; i < num_regions; i++) {
+		if (fwrite(&regions[i]->bank, sizeof(regions[i]->bank), 1, f) != 1 ||
+				fwrite(regions[i]->mem, ROM_BANK_SIZE, 1, f) != 1)
+			return -1;
+	}
+	return 0;
+}
+
+// a block of an image must be exactly what decoding its region would give: whole
+// instructions from start to end, ending in the flow and target it claims
+static bool check_image_block(const struct cfg_block *blk, const uint8_t *mem, uint32_t base) {
+	if (blk->start < base || blk->start >= blk->end || blk->end > base + ROM_BANK_SIZE ||
+			blk->last < blk->start || blk->last >= blk->end || blk->target > 0xffff ||
+			(uint32_t)blk->flow > FLOW_RETI)
+		return false;
+
+	uint32_t addr = blk->start, last = addr, num_instrs = 0;
+	while (addr < blk->end) {
+		last = addr;
+		num_instrs++;
+		addr += disasm_op_len(mem[addr - base]);
+	}
+	if (addr != blk->end || last != blk->last || num_instrs != blk->num_instrs)
+		return false;
+
+	// the region in the image isn't padded like those in memory
+	uint8_t bytes[3] = {};
+	uint32_t avail = base + ROM_BANK_SIZE - last;
+	memcpy(bytes, &mem[last - base], avail < sizeof(bytes) ? avail : sizeof(bytes));
+	uint32_t target = 0;
+	enum disasm_flow flow = disasm_op_flow(bytes, last, &target);
+	return flow == blk->flow && (!has_target(flow) || target == blk->target);
+}
+
+// back to an empty graph after a bad image; the regions are read again from the emulator
+static void drop_image() {
+	cfg.num_blocks = 0;
+	cfg.num_xrefs = 0;
+	memset(cfg.xref_head, 0, sizeof(cfg.xref_head));
+	struct cfg_region *regions[CFG_MAX_BANKS+1] = { cfg.bank0 };
+	memcpy(&regions[1], cfg.banks, sizeof(cfg.banks));
+	for (size_t i = 0; i < CFG_MAX_BANKS+1; i++) {
+		if (!regions[i])
+			continue;
+		memset(regions[i]->block_of, 0, regions[i]->size * sizeof(*regions[i]->block_of));
+		regions[i]->valid = false;
+	}
+}
+
+// only bank 0 picks the cache file, so any other bank of the image may be out of date (a rom
+// rebuilt or patched without touching bank 0). it's compared with what the emulator has.
+static bool same_bank(uint32_t bank, const uint8_t *mem) {
+	static uint8_t buf[ROM_BANK_SIZE];
+	const struct cfg_region *region = cfg.banks[bank % CFG_MAX_BANKS];
+	if (region && region->valid && region->bank == bank)
+		return !memcmp(region->mem, mem, ROM_BANK_SIZE);
+	return client_read_rom_bank(bank, buf) != -1 && !memcmp(buf, mem, ROM_BANK_SIZE);
+}
+
+// load an image written by cfg_write_image into an empty graph. the whole image is checked
+// before anything is touched, except for blocks overlapping each other, which show up while
+// indexing them and drop everything loaded so far.
+int cfg_read_image(const uint8_t *buf, size_t size) {
+	struct cfg_image_header hdr;
+	if (cfg.num_blocks || size < sizeof(hdr))
+		return -1;
+	memcpy(&hdr, buf, sizeof(hdr));
+	size_t region_size = sizeof(uint32_t) + ROM_BANK_SIZE;
+	if (hdr.num_blocks > CFG_MAX_BLOCKS || hdr.num_xrefs > CFG_MAX_XREFS ||
+			hdr.num_regions > CFG_MAX_BANKS+1)
+		return -1;
+	if (size != sizeof(hdr) + hdr.num_blocks * sizeof(struct cfg_block) +
+			hdr.num_xrefs * sizeof(struct cfg_xref) + hdr.num_regions * region_size)
+		return -1;
+
+	const uint8_t *blocks = buf + sizeof(hdr);
+	const uint8_t *xrefs = blocks + hdr.num_blocks * sizeof(struct cfg_block);
+	const uint8_t *regions = xrefs + hdr.num_xrefs * sizeof(struct cfg_xref);
+
+	// the memory of each region in the image
+	const uint8_t *bank0_mem = NULL;
+	static const uint8_t *region_mem[CFG_MAX_BANKS];
+	static uint32_t region_bank[CFG_MAX_BANKS];
+	memset(region_mem, 0, sizeof(region_mem));
+	for (uint32_t i = 0; i < hdr.num_regions; i++) {
+		uint32_t bank;
+		memcpy(&bank, regions + i*region_size, sizeof(bank));
+		if (bank == CFG_BANK_RAM)
+			return -1;
+		const uint8_t *mem = regions + i*region_size + sizeof(bank);
+		if (!bank) {
+			bank0_mem = mem;
+		}
+		else {
+			if (!same_bank(bank, mem))
+				return -1;
+			region_mem[bank % CFG_MAX_BANKS] = mem;
+			region_bank[bank % CFG_MAX_BANKS] = bank;
+		}
+	}
+
+	// every block must be in a region of the image, and decode to itself
+	for (uint32_t i = 0; i < hdr.num_blocks; i++) {
+		struct cfg_block blk;
+		memcpy(&blk, blocks + i*sizeof(blk), sizeof(blk));
+		bool in_bank0 = blk.start < ROM_BANK_SIZE;
+		const uint8_t *mem = in_bank0 ? bank0_mem : region_mem[blk.bank % CFG_MAX_BANKS];
+		if (in_bank0 ? blk.bank != 0 : (!blk.bank || region_bank[blk.bank % CFG_MAX_BANKS] != blk.bank))
+			return -1;
+		if (!mem || !check_image_block(&blk, mem, in_bank0 ? 0 : ROM_BANK_SIZE))
+			return -1;
+	}
+	// and every reference must come from one of those regions
+	for (uint32_t i = 0; i < hdr.num_xrefs; i++) {
+		struct cfg_xref xref;
+		memcpy(&xref, xrefs + i*sizeof(xref), sizeof(xref));
+		if ((uint32_t)xref.kind > XREF_IMM)
+			return -1;
+		if (!xref.bank ? !bank0_mem || xref.from >= ROM_BANK_SIZE :
+				!region_mem[xref.bank % CFG_MAX_BANKS] ||
+				region_bank[xref.bank % CFG_MAX_BANKS] != xref.bank ||
+				!ADDR_IS_SWITCHABLE(xref.from))
+			return -1;
+	}
+
+	for (uint32_t i = 0; i < hdr.num_regions; i++) {
+		uint32_t bank;
+		memcpy(&bank, regions + i*region_size, sizeof(bank));
+		struct cfg_region **region = bank ? &cfg.banks[bank % CFG_MAX_BANKS] : &cfg.bank0;
+		if (!*region && !(*region = bank ? new_region(ROM_BANK_SIZE, ROM_BANK_SIZE, bank) :
+					new_region(0, ROM_BANK_SIZE, 0))) {
+			drop_image();
+			return -1;
+		}
+		memcpy((*region)->mem, regions + i*region_size + sizeof(bank), ROM_BANK_SIZE);
+		(*region)->valid = true;
+	}
+	for (uint32_t i = 0; i < hdr.num_blocks; i++) {
+		struct cfg_block *blk = &cfg.blocks[cfg.num_blocks];
+		memcpy(blk, blocks + i*sizeof(struct cfg_block), sizeof(struct cfg_block));
+		const struct cfg_region *region = blk->start < ROM_BANK_SIZE ?
+			cfg.bank0 : cfg.banks[blk->bank % CFG_MAX_BANKS];
+		for (uint32_t addr = blk->start; addr < blk->end;
+				addr += disasm_op_len(region->mem[addr - region->base])) {
+			if (region->block_of[addr - region->base]) {
+				drop_image();
+				return -1;
+			}
+		}
+		reindex_block(cfg.num_blocks++);
+	}
+	for (uint32_t i = 0; i < hdr.num_xrefs; i++) {
+		struct cfg_xref xref;
+		memcpy(&xref, xrefs + i*sizeof(xref), sizeof(xref));
+		add_xref(xref.bank, xref.from, xref.to, xref.kind);
+	}
+	return 0;
+}
+
+// drop everything that was decoded from ram, since it may have been rewritten
+void cfg_invalidate() {
+	if (!cfg.ram)
+		return;
+	cfg.ram->valid = false;
+
+	int num_blocks = 0;
+	for (int i = 0; i < cfg.num_blocks; i++) {
+		if (cfg.blocks[i].bank != CFG_BANK_RAM)
+			cfg.blocks[num_blocks++] = cfg.blocks[i];
+	}
+	if (num_blocks == cfg.num_blocks)
+		return;
+
+	// block indices changed; rebuild the maps of every region
+	cfg.num_blocks = num_blocks;
+	memset(cfg.ram->block_of, 0, cfg.ram->size * sizeof(*cfg.ram->block_of));
+	for (int i = 0; i < cfg.num_blocks; i++)
+		reindex_block(i);
+
+	int num_xrefs = 0;
+	memset(cfg.xref_head, 0, sizeof(cfg.xref_head));
+	for (int i = 0; i < cfg.num_xrefs; i++) {
+		struct cfg_xref xref = cfg.xrefs[i];
+		if (xref.bank == CFG_BANK_RAM)
+			continue;
+		xref.next = cfg.xref_head[xref.to];
+		cfg.xrefs[num_xrefs] = xref;
+		cfg.xref_head[xref.to] = ++num_xrefs;
+	}
+	cfg.num_xrefs = num_xrefs;
+}
+
+// state of a cost query: a depth-first walk over the blocks of [from, to) with memoization.
+// the walk finds the worst case; the best case is relaxed over the blocks it visited
+static struct {
+	uint32_t from, to;
+	uint8_t state[CFG_MAX_BLOCKS];
+	uint64_t best[CFG_MAX_BLOCKS], worst[CFG_MAX_BLOCKS];
+	int visited[CFG_MAX_BLOCKS]; // in post-order
+	int num_visited;
+	struct cfg_cost *cost;
+} query;
+
+enum {
+	BLOCK_UNVISITED,
+	BLOCK_VISITING,
+	BLOCK_DONE,
+};
+
+// leaving a block through one of its edges; `exits` if control leaves the range
+struct cost_edge {
+	uint32_t cycles;
+	bool exits;
+	uint32_t succ;
+};
+
+static uint64_t add_cycles(uint64_t a, uint64_t b) {
+	return a == CFG_COST_UNBOUNDED || b == CFG_COST_UNBOUNDED ? CFG_COST_UNBOUNDED : a + b;
+}
+
+static int block_edges(const struct cfg_block *blk, struct cost_edge *edges) {
+	switch (blk->flow) {
+		case FLOW_NONE:
+			edges[0] = (struct cost_edge){ blk->cycles, false, blk->end };
+			return 1;
+		case FLOW_CALL:
+		case FLOW_RST:
+			// the callee is not part of the range
+			edges[0] = (struct cost_edge){ blk->cycles_taken, false, blk->end };
+			return 1;
+		case FLOW_CALL_COND:
+			edges[0] = (struct cost_edge){ blk->cycles, false, blk->end };
+			edges[1] = (struct cost_edge){ blk->cycles_taken, false, blk->end };
+			return 2;
+		case FLOW_JUMP:
+			edges[0] = (struct cost_edge){ blk->cycles_taken, false, blk->target };
+			return 1;
+		case FLOW_JUMP_COND:
+			edges[0] = (struct cost_edge){ blk->cycles, false, blk->end };
+			edges[1] = (struct cost_edge){ blk->cycles_taken, false, blk->target };
+			return 2;
+		case FLOW_RET_COND:
+			edges[0] = (struct cost_edge){ blk->cycles, false, blk->end };
+			edges[1] = (struct cost_edge){ blk->cycles_taken, true, 0 };
+			return 2;
+		default:
+			edges[0] = (struct cost_edge){ blk->cycles_taken, true, 0 };
+			return 1;
+	}
+}
+
+// the block an edge of `blk` continues in, or -1 if control leaves the range through it
+static int edge_block(const struct cfg_block *blk, const struct cost_edge *edge) {
+	if (edge->exits || edge->succ < query.from || edge->succ >= query.to)
+		return -1;
+	uint32_t succ = in_bank(blk->bank, edge->succ);
+	return cfg_is_leader(succ) ? block_idx(succ) : -1;
+}
+
+// a path that reaches a block still being visited can go around the loop forever, so every
+// block on it is unbounded in the worst case, and memoizing that is right
+static uint64_t block_worst(int idx) {
+	if (query.state[idx] == BLOCK_DONE)
+		return query.worst[idx];
+	if (query.state[idx] == BLOCK_VISITING) {
+		query.cost->has_loop = true;
+		return CFG_COST_UNBOUNDED;
+	}
+	query.state[idx] = BLOCK_VISITING;
+	query.cost->num_blocks++;
+
+	struct cost_edge edges[2];
+	int num_edges = block_edges(&cfg.blocks[idx], edges);
+	uint64_t worst = 0;
+	for (int i = 0; i < num_edges; i++) {
+		int succ = edge_block(&cfg.blocks[idx], &edges[i]);
+		uint64_t w = succ == -1 ? edges[i].cycles : add_cycles(edges[i].cycles, block_worst(succ));
+		if (w > worst)
+			worst = w;
+	}
+
+	query.state[idx] = BLOCK_DONE;
+	query.worst[idx] = worst;
+	query.visited[query.num_visited++] = idx;
+	return worst;
+}
+
+// the shortest way out of every visited block. a walk cut short at back edges would get it
+// wrong for blocks inside loops, so the edges are relaxed until nothing changes instead; in
+// post-order, a graph without loops takes a single pass.
+static void relax_best() {
+	for (int i = 0; i < query.num_visited; i++)
+		query.best[query.visited[i]] = CFG_COST_UNBOUNDED;
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int i = 0; i < query.num_visited; i++) {
+			int idx = query.visited[i];
+			struct cost_edge edges[2];
+			int num_edges = block_edges(&cfg.blocks[idx], edges);
+			for (int j = 0; j < num_edges; j++) {
+				int succ = edge_block(&cfg.blocks[idx], &edges[j]);
+				uint64_t b = succ == -1 ? edges[j].cycles :
+					add_cycles(edges[j].cycles, query.best[succ]);
+				if (b < query.best[idx]) {
+					query.best[idx] = b;
+					changed = true;
+				}
+			}
+		}
+	}
+}
+
+// best and worst case cycles from entering `from` until control leaves [from, to), not
+// counting the routines called on the way
+int cfg_cost(uint32_t from, uint32_t to, struct cfg_cost *cost) {
+	// the range lies in the bank of its start
+	if (ADDR_IS_BANKED(to))
+		to = ADDR_OFFSET(to);
+	if (ADDR_OFFSET(from) >= to || cfg_explore(from) == -1 || !cfg_is_leader(from))
+		return -1;
+
+	uint32_t to_addr = ADDR_IS_BANKED(from) ? ADDR_BANKED(ADDR_BANK(from), to) : to;
+	int idx = to < 0x10000 ? block_idx(to_addr) : -1;
+	if (idx >= 0 && cfg.blocks[idx].start != to)
+		split_block(get_region(to_addr), idx, to);
+
+	*cost = (struct cfg_cost){};
+	query.from = ADDR_OFFSET(from);
+	query.to = to;
+	query.cost = cost;
+	query.num_visited = 0;
+	memset(query.state, BLOCK_UNVISITED, sizeof(query.state));
+	int from_idx = block_idx(from);
+	cost->worst = block_worst(from_idx);
+	relax_best();
+	cost->best = query.best[from_idx];
+
+	return 0;
+}
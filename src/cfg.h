@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "disasm.h"
+
+#define CFG_MAX_BLOCKS 32768
+#define CFG_MAX_XREFS 65536
+#define CFG_MAX_BANKS 512
+#define CFG_BANK_RAM UINT32_MAX
+#define CFG_COST_UNBOUNDED UINT64_MAX
+
+// a straight run of instructions that is only entered at `start` and left after `last`
+struct cfg_block {
+	uint32_t bank; // rom bank the block was decoded from, or CFG_BANK_RAM
+	uint16_t start;
+	uint16_t last;
+	uint32_t end; // one past the last instruction
+	enum disasm_flow flow; // of the last instruction
+	uint32_t target;
+	uint32_t num_instrs;
+	uint32_t cycles; // the last instruction not taking its branch
+	uint32_t cycles_taken;
+};
+
+enum cfg_xref_kind {
+	XREF_JUMP,
+	XREF_CALL,
+	XREF_READ,
+	XREF_WRITE,
+	XREF_IMM, // a 16-bit immediate, which is often a pointer
+};
+
+// a reference from the instruction at `from` to the address `to`
+struct cfg_xref {
+	uint32_t bank; // of `from`
+	uint16_t from;
+	uint16_t to;
+	enum cfg_xref_kind kind;
+	int next; // index+1 of the next reference to the same address, 0 if none
+};
+
+struct cfg_image_header {
+	uint32_t num_blocks;
+	uint32_t num_xrefs;
+	uint32_t num_regions;
+};
+
+struct cfg_cost {
+	uint64_t best, worst; // CFG_COST_UNBOUNDED if there's no such path
+	bool has_loop;
+	uint32_t num_blocks;
+};
+
+// the lookups below take banked addresses (ADDR_BANKED) to look into a switchable bank that
+// isn't mapped; plain addresses in 0x4000-0x7fff are those of the mapped bank
+void cfg_invalidate();
+void cfg_set_bank(uint32_t bank);
+void cfg_for_each_instr(void (*fn)(uint32_t bank, uint32_t addr, void *data), void *data);
+int cfg_explore(uint32_t addr);
+int cfg_explore_entries();
+const struct cfg_block *cfg_get_block(uint32_t addr);
+const uint8_t *cfg_get_mem(uint32_t addr);
+bool cfg_is_leader(uint32_t addr);
+const struct cfg_xref *cfg_first_xref(uint32_t addr);
+const struct cfg_xref *cfg_next_xref(const struct cfg_xref *xref);
+uint32_t cfg_xref_from(const struct cfg_xref *xref);
+int cfg_cost(uint32_t from, uint32_t to, struct cfg_cost *cost);
+uint32_t cfg_get_rom_generation();
+int cfg_write_image(FILE *f);
+int cfg_read_image(const uint8_t *buf, size_t size);
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cfg.h"
+#include "cfgcache.h"
+#include "client.h"
+
+static bool enabled;
+static char path[PATH_MAX];
+static uint64_t rom_hash;
+static uint32_t saved_generation;
+
+// bank 0 picks the cache file; the other banks of an image are checked against the emulator
+// as it's loaded, since hashing the whole rom up front would mean reading every bank of it
+static int hash_rom(uint64_t *hash) {
+	const uint8_t *bank0 = cfg_get_mem(0);
+	if (!bank0)
+		return -1;
+
+	// fnv-1a
+	*hash = 0xcbf29ce484222325ull;
+	for (uint32_t i = 0; i < ROM_BANK_SIZE; i++) {
+		*hash ^= bank0[i];
+		*hash *= 0x100000001b3ull;
+	}
+	return 0;
+}
+
+static int make_dir(const char *dir) {
+	if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+		perror("mkdir()");
+		return -1;
+	}
+	return 0;
+}
+
+static int cache_path(uint64_t hash) {
+	char dir[PATH_MAX];
+	const char *xdg = getenv("XDG_CACHE_HOME"), *home = getenv("HOME");
+	if (xdg && *xdg)
+		snprintf(dir, sizeof(dir), "%s", xdg);
+	else if (home && *home)
+		snprintf(dir, sizeof(dir), "%s/.cache", home);
+	else
+		return -1;
+	if (make_dir(dir) == -1)
+		return -1;
+
+	size_t len = strlen(dir);
+	snprintf(dir + len, sizeof(dir) - len, "/realboy-mon");
+	if (make_dir(dir) == -1)
+		return -1;
+	if (snprintf(path, sizeof(path), "%s/%016llx.cfg", dir, (unsigned long long)hash) >=
+			(int)sizeof(path))
+		return -1;
+	return 0;
+}
+
+// the image is only read through the mapping: the graph keeps blocks, references and region
+// maps in its own tables, whose indices and chains are rebuilt as they're copied in
+static int load(int fd) {
+	struct stat st;
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(struct cfgcache_header))
+		return -1;
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		perror("mmap()");
+		return -1;
+	}
+	int ret = -1;
+	const struct cfgcache_header *hdr = map;
+	if (hdr->magic == CFGCACHE_MAGIC && hdr->version == CFGCACHE_VERSION &&
+			hdr->rom_hash == rom_hash && hdr->image_size == st.st_size - sizeof(*hdr))
+		ret = cfg_read_image((const uint8_t *)map + sizeof(*hdr), hdr->image_size);
+	munmap(map, st.st_size);
+	return ret;
+}
+
+// find the cache of the rom in the emulator and load it into the graph, which must still be
+// empty. returns 1 if something was loaded, 0 if not, and -1 if the cache can't be used at
+// all. files from another version or that fail their checks are ignored, and overwritten
+// on the next save.
+int cfgcache_open() {
+	if (hash_rom(&rom_hash) == -1 || cache_path(rom_hash) == -1)
+		return -1;
+	enabled = true;
+	saved_generation = cfg_get_rom_generation();
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return 0;
+	int ret = load(fd) == -1 ? 0 : 1;
+	close(fd);
+	return ret;
+}
+
+// whether rom code was found or split since the last save (or load)
+bool cfgcache_is_dirty() {
+	return enabled && cfg_get_rom_generation() != saved_generation;
+}
+
+// the whole image is written to a temporary file that replaces the cache once complete, so a
+// crash never leaves a torn file behind. after a failure the cache isn't written again.
+int cfgcache_save() {
+	if (!enabled)
+		return -1;
+
+	char tmp[PATH_MAX+4];
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	FILE *f = fopen(tmp, "wb");
+	if (!f) {
+		perror("fopen()");
+		enabled = false;
+		return -1;
+	}
+
+	struct cfgcache_header hdr = {
+		.magic = CFGCACHE_MAGIC,
+		.version = CFGCACHE_VERSION,
+		.rom_hash = rom_hash,
+	};
+	if (fwrite(&hdr, sizeof(hdr), 1, f) != 1 || cfg_write_image(f) == -1)
+		goto err;
+	long end = ftell(f);
+	if (end == -1)
+		goto err;
+	hdr.image_size = end - sizeof(hdr);
+	if (fseek(f, 0, SEEK_SET) == -1 || fwrite(&hdr, sizeof(hdr), 1, f) != 1)
+		goto err;
+	if (fclose(f) == EOF) {
+		f = NULL;
+		goto err;
+	}
+	if (rename(tmp, path) == -1) {
+		perror("rename()");
+		unlink(tmp);
+		enabled = false;
+		return -1;
+	}
+	saved_generation = cfg_get_rom_generation();
+	return 0;
+err:
+	perror("cfgcache_save()");
+	if (f)
+		fclose(f);
+	unlink(tmp);
+	enabled = false;
+	return -1;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef CFGCACHE_H
+#define CFGCACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// the rom part of the control flow graph is kept on disk between sessions, one file per rom
+// under $XDG_CACHE_HOME/realboy-mon. the file is a header followed by a cfg image (see
+// cfg_write_image()); integers are stored in host byte order and the structures as they are
+// laid out in memory, so the version must be bumped whenever cfg_block or cfg_xref change.
+#define CFGCACHE_MAGIC 0x43474643 // "CFGC"
+#define CFGCACHE_VERSION 1
+
+struct cfgcache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t rom_hash;
+	uint64_t image_size;
+};
+
+int cfgcache_open();
+bool cfgcache_is_dirty();
+int cfgcache_save();
+
+#endif
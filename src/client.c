@@ -17,25 +17,143 @@
  */
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/socket.h>
-#include <sys/un.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include <libemu.h>
 
 #include "client.h"
+#include "disasm.h"
+#include "ipclog.h"
 
 bool server_is_executing;
+// set when the server reports a stop of its own (breakpoint, until...), until it runs again
+static bool server_stopped_itself;
+
+// registers and the code at pc, fetched in one request when the server stops and good until
+// it runs again
+static struct client_state state;
+static bool state_valid;
+
+// spans of code read ahead of time (client_prefetch_code), oldest replaced first. like the
+// state, they are dropped when the server runs.
+struct code_span {
+	uint32_t start;
+	uint32_t bank;
+	uint32_t len;
+	uint8_t code[CLIENT_PREFETCH_SPAN];
+};
+
+#define NUM_CODE_SPANS (CLIENT_PREFETCH_MAX_BYTES / CLIENT_PREFETCH_SPAN)
+
+static struct code_span code_spans[NUM_CODE_SPANS];
+static size_t next_code_span;
+
+static void invalidate_code() {
+	state_valid = false;
+	for (size_t i = 0; i < NUM_CODE_SPANS; i++)
+		code_spans[i].len = 0;
+}
+
+static void set_executing() {
+	server_is_executing = true;
+	server_stopped_itself = false;
+	invalidate_code();
+}
+
+// the rom bank mapped at 0x4000-0x7fff, as last reported by the server
+static uint32_t mapped_bank;
+static bool mapped_bank_known;
 
 struct dispatch_table dispatch_table;
 
+// every message goes through these two, so a capture (--record-ipc) sees all the traffic
+static int send_msg(const struct msg *msg) {
+	int ret = emu_send_msg(msg);
+	if (ret != -1)
+		ipclog_write(IPCLOG_SENT, msg);
+	return ret;
+}
+
+static int recv_msg(struct msg *msg, bool wait) {
+	int ret = emu_recv_msg(msg, wait);
+	if (ret != -1)
+		ipclog_write(IPCLOG_RECV, msg);
+	return ret;
+}
+
+// messages the server sends on its own while running, as opposed to replies
+static bool is_push_msg(const struct msg *msg) {
+	return (msg->hdr.type == TYPE_MONITOR && (msg->hdr.subtype.monitor == MONITOR_STATUS ||
+				msg->hdr.subtype.monitor == MONITOR_BANK_SWITCH)) ||
+		(msg->hdr.type == TYPE_CONTROL_FLOW &&
+		 msg->hdr.subtype.control_flow == CONTROL_FLOW_TRACEPOINT);
+}
+
+// the messages with which the server reports that it stopped on its own
+static bool is_stop_msg(const struct msg *msg) {
+	if (msg->hdr.type != TYPE_CONTROL_FLOW)
+		return false;
+	switch (msg->hdr.subtype.control_flow) {
+		case CONTROL_FLOW_UNTIL:
+		case CONTROL_FLOW_BREAK:
+		case CONTROL_FLOW_FRAME:
+		case CONTROL_FLOW_VBLANK:
+		case CONTROL_FLOW_LINE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static void dispatch_stop(const struct msg *msg) {
+	// ppu events stop like an until, at whatever pc the event hit
+	if (msg->hdr.subtype.control_flow == CONTROL_FLOW_BREAK)
+		dispatch_table.handle_control_flow_break(*(uint32_t*)msg->payload);
+	else
+		dispatch_table.handle_control_flow_until(*(uint32_t*)msg->payload);
+	server_is_executing = false;
+	server_stopped_itself = true;
+}
+
+static void dispatch_push(const struct msg *msg) {
+	if (msg->hdr.type == TYPE_MONITOR && msg->hdr.subtype.monitor == MONITOR_BANK_SWITCH) {
+		if (msg->hdr.size < 4)
+			return;
+		mapped_bank = *(uint32_t *)msg->payload;
+		mapped_bank_known = true;
+		if (dispatch_table.handle_bank_switch)
+			dispatch_table.handle_bank_switch(mapped_bank);
+	}
+	else if (msg->hdr.type == TYPE_MONITOR) {
+		if (msg->hdr.size >= sizeof(struct client_status) && dispatch_table.handle_monitor_status)
+			dispatch_table.handle_monitor_status(msg->payload);
+	}
+	else if (dispatch_table.handle_tracepoint_records) {
+		dispatch_table.handle_tracepoint_records(msg->payload,
+				msg->hdr.size / sizeof(struct client_tracepoint_record));
+	}
+}
+
 static int send_req_and_recv_reply(const struct msg *req, struct msg *reply) {
 	int ret;
-	if ((ret = emu_send_msg(req)) != -1) {
-		if (reply)
-			ret = emu_recv_msg(reply, true);
+	if ((ret = send_msg(req)) != -1) {
+		if (!reply)
+			return ret;
+		// status and tracepoint records pushed just before the server stopped may still
+		// be queued ahead of the reply, and so may a stop that crossed with a MONITOR_STOP
+		while ((ret = recv_msg(reply, true)) != -1 && (is_push_msg(reply) || is_stop_msg(reply))) {
+			if (is_stop_msg(reply))
+				dispatch_stop(reply);
+			else
+				dispatch_push(reply);
+			free(reply->payload);
+			*reply = (struct msg){};
+		}
 	}
 	return ret;
 }
@@ -44,7 +162,57 @@ static int send_req(const struct msg *req) {
 	return send_req_and_recv_reply(req, NULL);
 }
 
+// decode from `code`, read from `start` on in `bank`, if it holds the whole instruction
+static struct instruction *decode_cached(const uint8_t *code, uint32_t start, uint32_t code_len,
+		uint32_t code_bank, uint32_t addr) {
+	uint32_t bank = ADDR_IS_BANKED(addr) ? ADDR_BANK(addr) : mapped_bank;
+	if (ADDR_IS_SWITCHABLE(addr) && bank != code_bank)
+		return NULL;
+
+	uint32_t offset = ADDR_OFFSET(addr) - start;
+	if (ADDR_OFFSET(addr) < start || offset >= code_len)
+		return NULL;
+	uint32_t len = disasm_op_len(code[offset]);
+	if (offset + len > code_len)
+		return NULL;
+
+	// the same form the server replies with, one byte per word
+	uint32_t words[3];
+	for (uint32_t i = 0; i < len; i++)
+		words[i] = code[offset+i];
+
+	struct instruction *instr = malloc(sizeof(*instr));
+	if (!instr) {
+		perror("malloc()");
+		return NULL;
+	}
+	instr->addr = ADDR_OFFSET(addr);
+	instr->bank = ADDR_IS_SWITCHABLE(addr) ? bank : 0;
+	instr->len = len;
+	memset(instr->bytes, 0, sizeof(instr->bytes));
+	memcpy(instr->bytes, &code[offset], len);
+	instr->str = dispatch_table.handle_get_instr_at_addr(words, len*4);
+	return instr;
+}
+
+static struct instruction *get_cached_instruction(uint32_t addr) {
+	struct instruction *instr = NULL;
+	if (state_valid)
+		instr = decode_cached(state.code, state.regs[CPU_REG_PC], state.code_len, state.bank, addr);
+	for (size_t i = 0; !instr && i < NUM_CODE_SPANS; i++) {
+		const struct code_span *span = &code_spans[i];
+		if (span->len)
+			instr = decode_cached(span->code, span->start, span->len, span->bank, addr);
+	}
+	return instr;
+}
+
+// `addr` may be banked to disassemble from a bank that isn't mapped
 struct instruction *client_get_instruction(uint32_t addr) {
+	struct instruction *cached = get_cached_instruction(addr);
+	if (cached)
+		return cached;
+
 	struct msg req = (struct msg){
 		.hdr.type = TYPE_INSPECT,
 		.hdr.subtype.inspect = INSPECT_GET_INSTR_AT_ADDR,
@@ -56,6 +224,9 @@ struct instruction *client_get_instruction(uint32_t addr) {
 	char *disasm =
 		dispatch_table.handle_get_instr_at_addr(reply.payload, reply.hdr.size);
 	uint32_t op = *(uint32_t *)reply.payload;
+	uint8_t bytes[3] = {};
+	for (uint32_t i = 0; i < reply.hdr.size/4 && i < sizeof(bytes); i++)
+		bytes[i] = ((uint32_t *)reply.payload)[i];
 	free(reply.payload);
 
 	req = (struct msg){
@@ -69,13 +240,330 @@ struct instruction *client_get_instruction(uint32_t addr) {
 
 	// caller owns
 	struct instruction *instr = malloc(sizeof(*instr));
-	instr->addr = addr;
+	instr->addr = ADDR_OFFSET(addr);
+	instr->bank = client_get_addr_bank(addr);
 	instr->len = *(uint32_t*)reply.payload;
+	memcpy(instr->bytes, bytes, sizeof(bytes));
 	instr->str = disasm;
 	free((void *)reply.payload);
 	return instr;
 }
 
+// optionally, the server shares a copy of the address space through a memfd it passes over
+// the socket. it refreshes the copy every time it stops, so while stopped bulk reads are
+// served in place and only control messages go through the socket.
+struct shm_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t mem_offset;
+	uint32_t mem_size;
+};
+
+#define SHM_MAGIC 0x524d4853 // "SHMR"
+#define SHM_VERSION 1
+
+static struct {
+	const uint8_t *base;
+	size_t size;
+	const struct shm_header *hdr;
+} shm;
+
+// like send_req_and_recv_reply, for a reply that carries a file descriptor. libemu receives
+// it as ancillary data of the reply itself, so the stream keeps its framing; pushes queued
+// ahead of the reply carry none.
+static int send_req_and_recv_fd(const struct msg *req, struct msg *reply, int *fd) {
+	int ret;
+	*fd = -1;
+	if ((ret = send_msg(req)) == -1)
+		return ret;
+	while ((ret = emu_recv_msg_fd(reply, true, fd)) != -1) {
+		ipclog_write(IPCLOG_RECV, reply);
+		if (!is_push_msg(reply) && !is_stop_msg(reply))
+			break;
+		if (*fd != -1) {
+			close(*fd);
+			*fd = -1;
+		}
+		if (is_stop_msg(reply))
+			dispatch_stop(reply);
+		else
+			dispatch_push(reply);
+		free(reply->payload);
+		*reply = (struct msg){};
+	}
+	return ret;
+}
+
+// asks the server for the shared region; the reply carries its size, and the fd as
+// SCM_RIGHTS data
+int client_map_shm() {
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_MONITOR,
+		.hdr.subtype.monitor = MONITOR_MAP_SHM,
+		.hdr.size = 0,
+		.payload = 0
+	};
+	struct msg reply = {};
+	int fd;
+	if (send_req_and_recv_fd(&req, &reply, &fd) == -1)
+		goto err1;
+	if (fd == -1 || reply.hdr.size < 4)
+		goto err2;
+	size_t size = *(uint32_t *)reply.payload;
+	if (size < sizeof(struct shm_header))
+		goto err2;
+
+	void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	fd = -1;
+	if (base == MAP_FAILED) {
+		perror("mmap()");
+		goto err2;
+	}
+
+	const struct shm_header *hdr = base;
+	if (hdr->magic != SHM_MAGIC || hdr->version != SHM_VERSION ||
+			hdr->mem_offset > size || hdr->mem_size > size - hdr->mem_offset) {
+		fprintf(stderr, "client_map_shm: bad shared region\n");
+		munmap(base, size);
+		goto err2;
+	}
+
+	shm.base = base;
+	shm.size = size;
+	shm.hdr = hdr;
+	free(reply.payload);
+	return 0;
+err2:
+	if (fd != -1)
+		close(fd);
+	free(reply.payload);
+err1:
+	return -1;
+}
+
+// points straight into the shared copy of memory, or NULL if the range isn't shared (or
+// the server is running and the copy is stale). valid until the server runs again.
+const uint8_t *client_get_mem_view(uint32_t addr, uint32_t len) {
+	if (!shm.base || server_is_executing)
+		return NULL;
+	if (addr > shm.hdr->mem_size || len > shm.hdr->mem_size - addr)
+		return NULL;
+	return shm.base + shm.hdr->mem_offset + addr;
+}
+
+int client_read_mem(uint32_t addr, uint32_t len, uint8_t *buf) {
+	const uint8_t *view = client_get_mem_view(addr, len);
+	if (view) {
+		memcpy(buf, view, len);
+		return 0;
+	}
+
+	uint32_t range[2] = { addr, len };
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_INSPECT,
+		.hdr.subtype.inspect = INSPECT_GET_MEM,
+		.hdr.size = sizeof(range),
+		.payload = range
+	};
+	struct msg reply = {};
+	if (send_req_and_recv_reply(&req, &reply) == -1)
+		return -1;
+	int ret = reply.hdr.size >= len ? 0 : -1;
+	if (!ret)
+		memcpy(buf, reply.payload, len);
+	free(reply.payload);
+	return ret;
+}
+
+// several ranges in one request; their bytes come back one after the other in `buf`
+int client_read_mem_batch(const struct client_mem_range *ranges, size_t num, uint8_t *buf) {
+	size_t total = 0;
+	bool shared = true;
+	for (size_t i = 0; i < num; i++) {
+		total += ranges[i].len;
+		shared = shared && client_get_mem_view(ranges[i].addr, ranges[i].len);
+	}
+	if (!num)
+		return 0;
+	if (shared) {
+		for (size_t i = 0; i < num; i++) {
+			memcpy(buf, client_get_mem_view(ranges[i].addr, ranges[i].len), ranges[i].len);
+			buf += ranges[i].len;
+		}
+		return 0;
+	}
+
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_INSPECT,
+		.hdr.subtype.inspect = INSPECT_GET_MEM_BATCH,
+		.hdr.size = num * sizeof(*ranges),
+		.payload = (void *)ranges
+	};
+	struct msg reply = {};
+	if (send_req_and_recv_reply(&req, &reply) == -1)
+		return -1;
+	int ret = reply.hdr.size >= total ? 0 : -1;
+	if (!ret)
+		memcpy(buf, reply.payload, total);
+	free(reply.payload);
+	return ret;
+}
+
+int client_read_rom_bank(uint32_t bank, uint8_t *buf) {
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_INSPECT,
+		.hdr.subtype.inspect = INSPECT_GET_ROM_BANK,
+		.hdr.size = 4,
+		.payload = &bank
+	};
+	struct msg reply = {};
+	if (send_req_and_recv_reply(&req, &reply) == -1)
+		return -1;
+	int ret = reply.hdr.size >= ROM_BANK_SIZE ? 0 : -1;
+	if (!ret)
+		memcpy(buf, reply.payload, ROM_BANK_SIZE);
+	free(reply.payload);
+	return ret;
+}
+
+// the executed-address bitmaps of every rom bank, one bit per address and ROM_BANK_SIZE/8
+// bytes per bank, in a single transfer. the caller owns *bitmap.
+int client_get_coverage(uint8_t **bitmap, size_t *size) {
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_INSPECT,
+		.hdr.subtype.inspect = INSPECT_GET_COVERAGE,
+		.hdr.size = 0,
+		.payload = 0
+	};
+	struct msg reply = {};
+	if (send_req_and_recv_reply(&req, &reply) == -1)
+		return -1;
+	*bitmap = reply.payload;
+	*size = reply.hdr.size;
+	return 0;
+}
+
+// registers, mapped bank and `code_len` bytes of code from pc in a single request. until
+// the server runs again, registers and the instructions in that range are served from it.
+int client_get_state(uint32_t code_len) {
+	if (code_len > CLIENT_STATE_MAX_CODE)
+		code_len = CLIENT_STATE_MAX_CODE;
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_INSPECT,
+		.hdr.subtype.inspect = INSPECT_GET_STATE,
+		.hdr.size = 4,
+		.payload = &code_len
+	};
+	struct msg reply = {};
+	if (send_req_and_recv_reply(&req, &reply) == -1)
+		return -1;
+
+	size_t header = offsetof(struct client_state, code);
+	if (reply.hdr.size < header) {
+		free(reply.payload);
+		return -1;
+	}
+	memset(&state, 0, sizeof(state));
+	memcpy(&state, reply.payload, reply.hdr.size < sizeof(state) ? reply.hdr.size : sizeof(state));
+	free(reply.payload);
+	if (state.code_len > reply.hdr.size - header)
+		state.code_len = reply.hdr.size - header;
+	if (state.code_len > CLIENT_STATE_MAX_CODE)
+		state.code_len = CLIENT_STATE_MAX_CODE;
+
+	mapped_bank = state.bank;
+	mapped_bank_known = true;
+	state_valid = true;
+	return 0;
+}
+
+// the state of the last client_get_state, or NULL once the server ran
+const struct client_state *client_get_last_state() {
+	return state_valid ? &state : NULL;
+}
+
+// the server reports bank switches when it stops (MONITOR_BANK_SWITCH), so it is only asked
+// once
+uint32_t client_get_mapped_bank() {
+	if (mapped_bank_known)
+		return mapped_bank;
+
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_INSPECT,
+		.hdr.subtype.inspect = INSPECT_GET_ROM_BANK_NUM,
+		.hdr.size = 0,
+		.payload = 0
+	};
+	struct msg reply = {};
+	if (send_req_and_recv_reply(&req, &reply) == -1)
+		return 1;
+	if (reply.hdr.size >= 4) {
+		mapped_bank = *(uint32_t *)reply.payload;
+		mapped_bank_known = true;
+	}
+	free(reply.payload);
+	return mapped_bank_known ? mapped_bank : 1;
+}
+
+// the rom bank an address refers to: its own for banked addresses, the mapped one for plain
+// addresses in the switchable area, and 0 elsewhere
+uint32_t client_get_addr_bank(uint32_t addr) {
+	if (ADDR_IS_BANKED(addr))
+		return ADDR_BANK(addr);
+	return ADDR_IS_SWITCHABLE(addr) ? client_get_mapped_bank() : 0;
+}
+
+static bool span_holds(const struct code_span *span, uint32_t bank, uint32_t start, uint32_t len) {
+	return span->len && (!ADDR_IS_SWITCHABLE(start) || span->bank == bank) &&
+		start >= span->start && start + len <= span->start + span->len;
+}
+
+bool client_is_code_cached(uint32_t addr, uint32_t len) {
+	uint32_t bank = client_get_addr_bank(addr), start = ADDR_OFFSET(addr);
+	if (state_valid && span_holds(&(struct code_span){ .start = state.regs[CPU_REG_PC],
+				.bank = state.bank, .len = state.code_len }, bank, start, len))
+		return true;
+	for (size_t i = 0; i < NUM_CODE_SPANS; i++) {
+		if (span_holds(&code_spans[i], bank, start, len))
+			return true;
+	}
+	return false;
+}
+
+// read up to CLIENT_PREFETCH_SPAN bytes of code from `addr` into the oldest span, so that
+// client_get_instruction serves them locally until the server runs. code in a bank that isn't
+// mapped can't be read this way and is skipped.
+int client_prefetch_code(uint32_t addr, uint32_t len) {
+	uint32_t bank = client_get_addr_bank(addr), start = ADDR_OFFSET(addr);
+	if (server_is_executing || (ADDR_IS_SWITCHABLE(start) && bank != client_get_mapped_bank()))
+		return -1;
+	if (len > CLIENT_PREFETCH_SPAN)
+		len = CLIENT_PREFETCH_SPAN;
+	if (len > 0x10000 - start)
+		len = 0x10000 - start;
+	if (!len || client_is_code_cached(addr, len))
+		return 0;
+
+	struct code_span *span = &code_spans[next_code_span];
+	span->len = 0;
+	if (client_read_mem(start, len, span->code) == -1)
+		return -1;
+	span->start = start;
+	span->bank = bank;
+	span->len = len;
+	next_code_span = (next_code_span+1) % NUM_CODE_SPANS;
+	return 0;
+}
+
+uint32_t client_get_rom_banks() {
+	// the cartridge header encodes the rom size as 32KiB << n
+	uint8_t rom_size;
+	if (client_read_mem(0x148, 1, &rom_size) == -1 || rom_size > 8)
+		return 2;
+	return 2 << rom_size;
+}
+
 uint32_t client_get_ppu_reg(enum ppu_reg reg) {
 	struct msg req = (struct msg){
 		.hdr.type = TYPE_INSPECT,
@@ -91,6 +579,9 @@ uint32_t client_get_ppu_reg(enum ppu_reg reg) {
 }
 
 uint32_t client_get_cpu_reg(enum cpu_reg reg) {
+	if (state_valid && reg <= CPU_REG_PC)
+		return state.regs[reg];
+
 	struct msg req = (struct msg){
 		.hdr.type = TYPE_INSPECT,
 		.hdr.subtype.inspect = INSPECT_GET_CPU_REG,
@@ -112,31 +603,60 @@ void client_control_flow_until(uint32_t addr) {
 		.payload = &addr
 	};
 	send_req(&req);
-	server_is_executing = true;
+	set_executing();
 }
 
-void client_recv_msg_and_dispatch(bool wait) {
-	struct msg msg;
-	emu_recv_msg(&msg, wait);
+// runs until a ppu event: the start of the n-th next frame, the next vblank or the next
+// time ly reaches a line. the server replies once, when it stops.
+static void control_flow_ppu(enum control_flow event, uint32_t arg, bool has_arg) {
+	struct msg req = {
+		.hdr.type = TYPE_CONTROL_FLOW,
+		.hdr.subtype.control_flow = event,
+		.hdr.size = has_arg ? 4 : 0,
+		.payload = has_arg ? &arg : 0
+	};
+	send_req(&req);
+	set_executing();
+}
+
+void client_control_flow_frame(uint32_t num_frames) {
+	control_flow_ppu(CONTROL_FLOW_FRAME, num_frames, true);
+}
+
+void client_control_flow_vblank() {
+	control_flow_ppu(CONTROL_FLOW_VBLANK, 0, false);
+}
+
+void client_control_flow_line(uint32_t ly) {
+	control_flow_ppu(CONTROL_FLOW_LINE, ly, true);
+}
+
+// returns false if no message was received
+bool client_recv_msg_and_dispatch(bool wait) {
+	struct msg msg = {};
+	if (recv_msg(&msg, wait) == -1)
+		return false;
 
 	switch (msg.hdr.type) {
 		case TYPE_CONTROL_FLOW:
-			switch (msg.hdr.subtype.control_flow) {
-				case CONTROL_FLOW_UNTIL:
-					dispatch_table.handle_control_flow_until(*(uint32_t*)msg.payload);
-					server_is_executing = false;
-					break;
-				case CONTROL_FLOW_BREAK:
-					dispatch_table.handle_control_flow_break(*(uint32_t*)msg.payload);
-					server_is_executing = false;
-					break;
-				default:
-					fprintf(stderr, "client_recv_msg_and_dispatch SUBTYPE\n");
-			}
+			if (is_stop_msg(&msg))
+				dispatch_stop(&msg);
+			else if (is_push_msg(&msg))
+				dispatch_push(&msg);
+			else
+				fprintf(stderr, "client_recv_msg_and_dispatch SUBTYPE\n");
+			break;
+		case TYPE_MONITOR:
+			if (is_push_msg(&msg))
+				dispatch_push(&msg);
+			else
+				fprintf(stderr, "client_recv_msg_and_dispatch SUBTYPE\n");
 			break;
 		default:
 			fprintf(stderr, "client_recv_msg_and_dispatch TYPE\n");
 	}
+	free(msg.payload);
+	return true;
 }
 
 void client_control_flow_next() {
@@ -147,6 +667,7 @@ void client_control_flow_next() {
 		.payload = 0
 	};
 	send_req(&req);
+	invalidate_code();
 }
 
 void client_set_breakpoint(uint32_t addr) {
@@ -159,6 +680,48 @@ void client_set_breakpoint(uint32_t addr) {
 	send_req(&req);
 }
 
+// the server lets the first `ignore` hits go by without stopping; it keeps counting hits
+void client_set_breakpoint_ignore(uint32_t addr, uint32_t ignore) {
+	uint32_t bp[2] = { addr, ignore };
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_CONTROL_FLOW,
+		.hdr.subtype.control_flow = CONTROL_FLOW_BREAK,
+		.hdr.size = sizeof(bp),
+		.payload = bp
+	};
+	send_req(&req);
+}
+
+// hits of every breakpoint and tracepoint, as counted by the server. returns how many there
+// are, storing at most `max`.
+int client_get_breakpoint_hits(struct client_breakpoint_hits *hits, size_t max) {
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_INSPECT,
+		.hdr.subtype.inspect = INSPECT_GET_BREAKPOINT_HITS,
+		.hdr.size = 0,
+		.payload = 0
+	};
+	struct msg reply = {};
+	if (send_req_and_recv_reply(&req, &reply) == -1)
+		return -1;
+	size_t num = reply.hdr.size / sizeof(*hits);
+	memcpy(hits, reply.payload, (num < max ? num : max) * sizeof(*hits));
+	free(reply.payload);
+	return num;
+}
+
+// a tracepoint records the registers into a buffer on the server and keeps running. records
+// come back in batches while running, and whatever is left is flushed before a stop.
+void client_set_tracepoint(uint32_t addr) {
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_CONTROL_FLOW,
+		.hdr.subtype.control_flow = CONTROL_FLOW_TRACEPOINT,
+		.hdr.size = 4,
+		.payload = &addr
+	};
+	send_req(&req);
+}
+
 void client_unset_breakpoint(uint32_t addr) {
 	struct msg req = (struct msg){
 		.hdr.type = TYPE_CONTROL_FLOW,
@@ -177,13 +740,21 @@ void client_control_flow_continue() {
 		.payload = 0
 	};
 	send_req(&req);
-	server_is_executing = true;
+	set_executing();
+}
+
+int client_get_fd() {
+	return emu_get_fd();
 }
 
 bool client_is_server_executing() {
 	return server_is_executing;
 }
 
+bool client_server_stopped_itself() {
+	return server_stopped_itself;
+}
+
 void client_resume_server() {
 	struct msg req = (struct msg){
 		.hdr.type = TYPE_MONITOR,
@@ -192,7 +763,7 @@ void client_resume_server() {
 		.payload = 0
 	};
 	send_req(&req);
-	server_is_executing = true;
+	set_executing();
 }
 
 void client_stop_server() {
@@ -206,6 +777,18 @@ void client_stop_server() {
 	server_is_executing = false;
 }
 
+// the server pushes a status record at most `rate` times per second while it runs, and
+// none while stopped; a rate of 0 cancels the subscription.
+void client_subscribe_status(uint32_t rate) {
+	struct msg req = (struct msg){
+		.hdr.type = TYPE_MONITOR,
+		.hdr.subtype.monitor = MONITOR_SUBSCRIBE,
+		.hdr.size = 4,
+		.payload = &rate
+	};
+	send_req(&req);
+}
+
 int client_init(const struct dispatch_table *disp) {
 	dispatch_table = *disp;
 	return emu_init(false);
@@ -21,12 +21,70 @@
 
 #include <libemu.h>
 
+#define ROM_BANK_SIZE 0x4000
+
+// addresses in the switchable area 0x4000-0x7fff are ambiguous on their own. a banked
+// address names the rom bank too: bit 31 set, bank in bits 16-30 and address in bits 0-15.
+// a plain 16-bit address means whatever is mapped.
+#define ADDR_BANKED_FLAG 0x80000000u
+#define ADDR_BANKED(bank, addr) (ADDR_BANKED_FLAG | ((bank) & 0x7fff) << 16 | ((addr) & 0xffff))
+#define ADDR_IS_BANKED(addr) (((addr) & ADDR_BANKED_FLAG) != 0)
+#define ADDR_BANK(addr) (((addr) >> 16) & 0x7fff)
+#define ADDR_OFFSET(addr) ((addr) & 0xffff)
+#define ADDR_IS_SWITCHABLE(addr) (ADDR_OFFSET(addr) >= ROM_BANK_SIZE && ADDR_OFFSET(addr) < 2*ROM_BANK_SIZE)
+
 struct instruction {
 	uint16_t addr;
+	uint32_t bank; // rom bank the instruction was decoded from; 0 outside 0x4000-0x7fff
 	uint32_t len;
+	uint8_t bytes[3];
 	char *str;
 };
 
+#define CLIENT_STATE_MAX_CODE 512
+
+// reply to INSPECT_GET_STATE
+struct client_state {
+	uint32_t regs[CPU_REG_PC+1]; // indexed by enum cpu_reg
+	uint32_t bank; // mapped at 0x4000-0x7fff
+	uint32_t code_len;
+	uint8_t code[CLIENT_STATE_MAX_CODE]; // from pc on
+};
+
+// code read ahead of time is kept in spans of at most CLIENT_PREFETCH_SPAN bytes, and
+// CLIENT_PREFETCH_MAX_BYTES in total
+#define CLIENT_PREFETCH_SPAN 512
+#define CLIENT_PREFETCH_MAX_BYTES 2048
+
+// request of INSPECT_GET_MEM_BATCH, one per range
+struct client_mem_range {
+	uint32_t addr;
+	uint32_t len;
+};
+
+// pushed by the server while it runs, once subscribed
+struct client_status {
+	uint32_t pc;
+	uint32_t ly;
+	uint32_t frame;
+	uint32_t instrs_per_sec;
+	uint32_t frame_time_us;
+};
+
+struct client_tracepoint_record {
+	uint32_t addr;
+	uint32_t frame;
+	uint16_t af, bc, de, hl, sp;
+	uint16_t pad;
+};
+
+struct client_breakpoint_hits {
+	uint32_t addr;
+	uint32_t hits;
+	uint32_t ignore; // hits left to ignore
+	uint32_t is_tracepoint;
+};
+
 struct dispatch_table {
 	void (*handle_control_flow_until)(uint32_t addr);
 	void (*handle_control_flow_break)(uint32_t addr);
@@ -34,22 +92,49 @@ struct dispatch_table {
 	char *(*handle_get_cpu_reg)(uint32_t cpu_reg);
 	char *(*handle_get_ppu_reg)(uint32_t ppu_reg);
 	char *(*handle_get_instr_at_addr)(uint32_t *instr, uint32_t size);
+	void (*handle_monitor_status)(const struct client_status *status);
+	void (*handle_tracepoint_records)(const struct client_tracepoint_record *recs, size_t num);
+	void (*handle_bank_switch)(uint32_t bank);
 };
 int client_init(const struct dispatch_table *disp);
 
+int client_get_state(uint32_t code_len);
+const struct client_state *client_get_last_state();
 uint32_t client_get_cpu_reg(enum cpu_reg reg);
 uint32_t client_get_ppu_reg(enum ppu_reg reg);
 struct instruction *client_get_instruction(uint32_t addr);
+int client_read_mem(uint32_t addr, uint32_t len, uint8_t *buf);
+int client_read_mem_batch(const struct client_mem_range *ranges, size_t num, uint8_t *buf);
+int client_map_shm();
+const uint8_t *client_get_mem_view(uint32_t addr, uint32_t len);
+int client_read_rom_bank(uint32_t bank, uint8_t *buf);
+int client_prefetch_code(uint32_t addr, uint32_t len);
+bool client_is_code_cached(uint32_t addr, uint32_t len);
+uint32_t client_get_rom_banks();
+uint32_t client_get_mapped_bank();
+uint32_t client_get_addr_bank(uint32_t addr);
+int client_get_coverage(uint8_t **bitmap, size_t *size);
 
 void client_control_flow_until(uint32_t addr);
 void client_control_flow_continue();
 void client_control_flow_next();
+void client_control_flow_frame(uint32_t num_frames);
+void client_control_flow_vblank();
+void client_control_flow_line(uint32_t ly);
 
-void client_recv_msg_and_dispatch(bool wait);
+// the connection to the emulator, for waiting on it together with other events
+int client_get_fd();
+bool client_recv_msg_and_dispatch(bool wait);
 void client_set_breakpoint(uint32_t addr);
+void client_set_breakpoint_ignore(uint32_t addr, uint32_t ignore);
+int client_get_breakpoint_hits(struct client_breakpoint_hits *hits, size_t max);
+void client_set_tracepoint(uint32_t addr);
 void client_unset_breakpoint(uint32_t addr);
 void client_stop_server();
 void client_resume_server();
+void client_subscribe_status(uint32_t rate);
 bool client_is_server_executing();
+// whether the server reported a stop of its own (breakpoint, until...) since it last ran
+bool client_server_stopped_itself();
 
 #endif
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "coverage.h"
+
+// the emulator keeps one bit per rom address, set when an instruction starts there. the
+// whole map comes in one transfer and is kept until the next update.
+static uint8_t *bitmap;
+static uint32_t num_banks;
+
+int coverage_update() {
+	uint8_t *map;
+	size_t size;
+	if (client_get_coverage(&map, &size) == -1)
+		return -1;
+	if (size < COVERAGE_BANK_BYTES) {
+		free(map);
+		return -1;
+	}
+
+	free(bitmap);
+	bitmap = map;
+	num_banks = size / COVERAGE_BANK_BYTES;
+	return 0;
+}
+
+void coverage_disable() {
+	free(bitmap);
+	bitmap = NULL;
+	num_banks = 0;
+}
+
+bool coverage_is_enabled() {
+	return bitmap;
+}
+
+uint32_t coverage_get_num_banks() {
+	return num_banks;
+}
+
+// 1 if executed, 0 if not, -1 if there's no map for the address
+// `addr` may be banked; a plain address in the switchable area is one of the mapped bank
+int coverage_get(uint32_t addr) {
+	if (!bitmap || ADDR_OFFSET(addr) >= 2*ROM_BANK_SIZE)
+		return -1;
+	uint32_t bank = 0;
+	if (ADDR_IS_SWITCHABLE(addr))
+		bank = ADDR_IS_BANKED(addr) ? ADDR_BANK(addr) : client_get_mapped_bank();
+	if (bank >= num_banks)
+		return -1;
+	uint32_t offset = ADDR_OFFSET(addr) % ROM_BANK_SIZE;
+	const uint8_t *map = &bitmap[bank * COVERAGE_BANK_BYTES];
+	return map[offset / 8] >> (offset % 8) & 1;
+}
+
+static uint32_t count_bits(const uint8_t *map, size_t size) {
+	uint32_t count = 0;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		memcpy(&word, &map[i], sizeof(word));
+		count += __builtin_popcountll(word);
+	}
+	for (; i < size; i++)
+		count += __builtin_popcount(map[i]);
+	return count;
+}
+
+struct count_state {
+	struct coverage_stats *stats;
+	uint32_t num_banks;
+};
+
+static void count_decoded(uint32_t bank, uint32_t addr, void *data) {
+	struct count_state *state = data;
+	if (bank >= state->num_banks)
+		return;
+	state->stats[bank].decoded++;
+	if (coverage_get(ADDR_BANKED(bank, addr)) == 1)
+		state->stats[bank].decoded_executed++;
+}
+
+// fills the stats of the first `max_banks` banks and returns how many banks there are
+int coverage_get_stats(struct coverage_stats *stats, uint32_t max_banks) {
+	if (!bitmap)
+		return -1;
+
+	struct count_state state = {
+		.stats = stats,
+		.num_banks = max_banks < num_banks ? max_banks : num_banks,
+	};
+	memset(stats, 0, state.num_banks * sizeof(*stats));
+	for (uint32_t i = 0; i < state.num_banks; i++)
+		stats[i].executed = count_bits(&bitmap[i * COVERAGE_BANK_BYTES], COVERAGE_BANK_BYTES);
+	cfg_for_each_instr(count_decoded, &state);
+	return num_banks;
+}
+
+struct export_state {
+	uint8_t *decoded; // bitmap of the instructions known to the cfg, like the coverage map
+};
+
+static void mark_decoded(uint32_t bank, uint32_t addr, void *data) {
+	struct export_state *state = data;
+	if (bank >= num_banks)
+		return;
+	uint32_t offset = addr % ROM_BANK_SIZE;
+	state->decoded[bank * COVERAGE_BANK_BYTES + offset / 8] |= 1 << (offset % 8);
+}
+
+// one lcov record per bank, with the address standing for the line number. every executed
+// address and every decoded instruction gets a DA line, so code that never ran shows up
+// with a count of 0 as long as the cfg found it.
+int coverage_export(FILE *f) {
+	if (!bitmap)
+		return -1;
+
+	struct export_state state = { .decoded = calloc(num_banks, COVERAGE_BANK_BYTES) };
+	if (!state.decoded) {
+		perror("calloc()");
+		return -1;
+	}
+	cfg_for_each_instr(mark_decoded, &state);
+
+	fprintf(f, "TN:\n");
+	for (uint32_t bank = 0; bank < num_banks; bank++) {
+		const uint8_t *map = &bitmap[bank * COVERAGE_BANK_BYTES];
+		const uint8_t *decoded = &state.decoded[bank * COVERAGE_BANK_BYTES];
+		uint32_t base = bank ? ROM_BANK_SIZE : 0, found = 0, hit = 0;
+
+		fprintf(f, "SF:bank%02x\n", bank);
+		for (uint32_t offset = 0; offset < ROM_BANK_SIZE; offset++) {
+			bool executed = map[offset / 8] >> (offset % 8) & 1;
+			if (!executed && !(decoded[offset / 8] >> (offset % 8) & 1))
+				continue;
+			fprintf(f, "DA:%u,%d\n", base + offset, executed);
+			found++;
+			hit += executed;
+		}
+		fprintf(f, "LF:%u\nLH:%u\nend_of_record\n", found, hit);
+	}
+
+	free(state.decoded);
+	return ferror(f) ? -1 : 0;
+}
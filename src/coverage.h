@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "client.h"
+
+#define COVERAGE_BANK_BYTES (ROM_BANK_SIZE/8)
+
+struct coverage_stats {
+	uint32_t executed; // addresses the emulator ran an instruction from
+	uint32_t decoded; // instructions known to the cfg
+	uint32_t decoded_executed;
+};
+
+int coverage_update();
+void coverage_disable();
+bool coverage_is_enabled();
+uint32_t coverage_get_num_banks();
+int coverage_get(uint32_t addr);
+int coverage_get_stats(struct coverage_stats *stats, uint32_t num_banks);
+int coverage_export(FILE *f);
+
+#endif
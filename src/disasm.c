@@ -570,6 +570,65 @@ char *str_instrs_prefix[] = {
 	"set7 a, a",
 };
 
+static const uint8_t op_len[] = {
+	1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,
+	2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+	2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+	2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,
+	1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1,
+	2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+	2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+};
+
+// cycle counts in clock cycles (4 per machine cycle). conditional jumps, calls and returns
+// take longer when the branch is taken.
+static const uint8_t op_cycles[] = {
+	 4, 12,  8,  8,  4,  4,  8,  4, 20,  8,  8,  8,  4,  4,  8,  4,
+	 4, 12,  8,  8,  4,  4,  8,  4, 12,  8,  8,  8,  4,  4,  8,  4,
+	 8, 12,  8,  8,  4,  4,  8,  4,  8,  8,  8,  8,  4,  4,  8,  4,
+	 8, 12,  8,  8, 12, 12, 12,  4,  8,  8,  8,  8,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 8,  8,  8,  8,  8,  8,  4,  8,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 8, 12, 12, 16, 12, 16,  8, 16,  8, 16, 12,  4, 12, 24,  8, 16,
+	 8, 12, 12,  4, 12, 16,  8, 16,  8, 16, 12,  4, 12,  4,  8, 16,
+	12, 12,  8,  4,  4, 16,  8, 16, 16,  4, 16,  4,  4,  4,  8, 16,
+	12, 12,  8,  4,  4, 16,  8, 16, 12,  8, 16,  4,  4,  4,  8, 16,
+};
+
+static const uint8_t op_cycles_taken[] = {
+	 4, 12,  8,  8,  4,  4,  8,  4, 20,  8,  8,  8,  4,  4,  8,  4,
+	 4, 12,  8,  8,  4,  4,  8,  4, 12,  8,  8,  8,  4,  4,  8,  4,
+	12, 12,  8,  8,  4,  4,  8,  4, 12,  8,  8,  8,  4,  4,  8,  4,
+	12, 12,  8,  8, 12, 12, 12,  4, 12,  8,  8,  8,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 8,  8,  8,  8,  8,  8,  4,  8,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	 4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	20, 12, 16, 16, 24, 16,  8, 16, 20, 16, 16,  4, 24, 24,  8, 16,
+	20, 12, 16,  4, 24, 16,  8, 16, 20, 16, 16,  4, 24,  4,  8, 16,
+	12, 12,  8,  4,  4, 16,  8, 16, 16,  4, 16,  4,  4,  4,  8, 16,
+	12, 12,  8,  4,  4, 16,  8, 16, 12,  8, 16,  4,  4,  4,  8, 16,
+};
+
 char *disasm(uint32_t *instr, size_t size) {
 	char *dis = NULL;
 	uint8_t opcode = (uint8_t)instr[0];
@@ -596,3 +655,81 @@ char *disasm(uint32_t *instr, size_t size) {
 	}
 	return dis;
 }
+
+uint32_t disasm_op_len(uint8_t opcode) {
+	return op_len[opcode];
+}
+
+const char *disasm_template(const uint8_t *bytes) {
+	if (bytes[0] == 0xcb)
+		return str_instrs_prefix[bytes[1]];
+	return str_instrs[bytes[0]];
+}
+
+// same output as disasm(), but decodes raw memory bytes into a caller-provided buffer.
+// `bytes` must hold at least disasm_op_len(bytes[0]) bytes.
+int disasm_bytes(const uint8_t *bytes, char *buf, size_t size) {
+	uint8_t opcode = bytes[0];
+	switch (op_len[opcode]) {
+		case 3:
+			return snprintf(buf, size, str_instrs[opcode], bytes[1] | (bytes[2] << 8));
+		case 2:
+			if (opcode == 0xcb)
+				return snprintf(buf, size, "%s", str_instrs_prefix[bytes[1]]);
+			return snprintf(buf, size, str_instrs[opcode], (int8_t)bytes[1]); // value is signed
+		default:
+			return snprintf(buf, size, "%s", str_instrs[opcode]);
+	}
+}
+
+uint32_t disasm_op_cycles(const uint8_t *bytes, bool taken) {
+	if (bytes[0] == 0xcb) {
+		// operations on (hl) are slower; bit only reads it
+		if ((bytes[1] & 7) != 6)
+			return 8;
+		return bytes[1] >= 0x40 && bytes[1] < 0x80 ? 12 : 16;
+	}
+	return taken ? op_cycles_taken[bytes[0]] : op_cycles[bytes[0]];
+}
+
+// classify how an instruction at `addr` transfers control; `target` gets the destination of
+// direct jumps, calls and rsts.
+enum disasm_flow disasm_op_flow(const uint8_t *bytes, uint32_t addr, uint32_t *target) {
+	uint8_t op = bytes[0];
+	uint32_t imm16 = bytes[1] | (bytes[2] << 8);
+
+	switch (op) {
+		case 0x18:
+			*target = (uint16_t)(addr + 2 + (int8_t)bytes[1]);
+			return FLOW_JUMP;
+		case 0x20: case 0x28: case 0x30: case 0x38:
+			*target = (uint16_t)(addr + 2 + (int8_t)bytes[1]);
+			return FLOW_JUMP_COND;
+		case 0xc3:
+			*target = imm16;
+			return FLOW_JUMP;
+		case 0xc2: case 0xca: case 0xd2: case 0xda:
+			*target = imm16;
+			return FLOW_JUMP_COND;
+		case 0xe9:
+			return FLOW_JUMP_INDIRECT;
+		case 0xcd:
+			*target = imm16;
+			return FLOW_CALL;
+		case 0xc4: case 0xcc: case 0xd4: case 0xdc:
+			*target = imm16;
+			return FLOW_CALL_COND;
+		case 0xc7: case 0xcf: case 0xd7: case 0xdf:
+		case 0xe7: case 0xef: case 0xf7: case 0xff:
+			*target = op & 0x38;
+			return FLOW_RST;
+		case 0xc9:
+			return FLOW_RET;
+		case 0xc0: case 0xc8: case 0xd0: case 0xd8:
+			return FLOW_RET_COND;
+		case 0xd9:
+			return FLOW_RETI;
+		default:
+			return FLOW_NONE;
+	}
+}
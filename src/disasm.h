@@ -19,8 +19,27 @@
 #ifndef DISASM_H
 #define DISASM_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <sys/types.h>
 
+enum disasm_flow {
+	FLOW_NONE,
+	FLOW_JUMP,
+	FLOW_JUMP_COND,
+	FLOW_JUMP_INDIRECT,
+	FLOW_CALL,
+	FLOW_CALL_COND,
+	FLOW_RST,
+	FLOW_RET,
+	FLOW_RET_COND,
+	FLOW_RETI,
+};
+
 char *disasm(uint32_t *instr, size_t size);
+uint32_t disasm_op_len(uint8_t opcode);
+const char *disasm_template(const uint8_t *bytes);
+int disasm_bytes(const uint8_t *bytes, char *buf, size_t size);
+uint32_t disasm_op_cycles(const uint8_t *bytes, bool taken);
+enum disasm_flow disasm_op_flow(const uint8_t *bytes, uint32_t addr, uint32_t *target);
 #endif
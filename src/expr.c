@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libemu.h>
+
+#include "expr.h"
+
+// the 8-bit registers are views into their pairs
+static const struct {
+	const char *name;
+	enum cpu_reg reg;
+	uint32_t shift, mask;
+} regs[] = {
+	{ "a", CPU_REG_AF, 8, 0xff },
+	{ "f", CPU_REG_AF, 0, 0xff },
+	{ "b", CPU_REG_BC, 8, 0xff },
+	{ "c", CPU_REG_BC, 0, 0xff },
+	{ "d", CPU_REG_DE, 8, 0xff },
+	{ "e", CPU_REG_DE, 0, 0xff },
+	{ "h", CPU_REG_HL, 8, 0xff },
+	{ "l", CPU_REG_HL, 0, 0xff },
+	{ "af", CPU_REG_AF, 0, 0xffff },
+	{ "bc", CPU_REG_BC, 0, 0xffff },
+	{ "de", CPU_REG_DE, 0, 0xffff },
+	{ "hl", CPU_REG_HL, 0, 0xffff },
+	{ "sp", CPU_REG_SP, 0, 0xffff },
+	{ "pc", CPU_REG_PC, 0, 0xffff },
+};
+
+// recursive descent, with c's precedence for the operators
+struct parser {
+	const char *p;
+	struct expr *expr;
+	int depth; // of the stack when the program runs
+};
+
+#define EXPR_MAX_STACK 16
+
+static int parse_or(struct parser *ps);
+
+static void skip_space(struct parser *ps) {
+	while (isspace((unsigned char)*ps->p))
+		ps->p++;
+}
+
+static int emit(struct parser *ps, struct expr_insn insn, int depth_change) {
+	if (ps->expr->len == EXPR_MAX_CODE)
+		return -1;
+	ps->depth += depth_change;
+	if (ps->depth > EXPR_MAX_STACK)
+		return -1;
+	ps->expr->code[ps->expr->len++] = insn;
+	return 0;
+}
+
+static bool accept(struct parser *ps, const char *tok) {
+	skip_space(ps);
+	size_t len = strlen(tok);
+	if (strncmp(ps->p, tok, len))
+		return false;
+	ps->p += len;
+	return true;
+}
+
+// [addr] or word [addr]
+static int parse_load(struct parser *ps, uint32_t size) {
+	if (ps->expr->num_loads == EXPR_MAX_LOADS || parse_or(ps) == -1 || !accept(ps, "]"))
+		return -1;
+	struct expr_insn insn = { .op = EXPR_LOAD, .size = size, .slot = ps->expr->num_loads++ };
+	return emit(ps, insn, 0);
+}
+
+static int parse_primary(struct parser *ps) {
+	skip_space(ps);
+	if (accept(ps, "(")) {
+		if (parse_or(ps) == -1 || !accept(ps, ")"))
+			return -1;
+		return 0;
+	}
+	if (accept(ps, "["))
+		return parse_load(ps, 1);
+
+	if (isdigit((unsigned char)*ps->p) || *ps->p == '$') {
+		char *end;
+		uint32_t val = *ps->p == '$' ? strtoul(ps->p+1, &end, 16) : strtoul(ps->p, &end, 0);
+		if (end == ps->p || (end == ps->p+1 && *ps->p == '$'))
+			return -1;
+		ps->p = end;
+		return emit(ps, (struct expr_insn){ .op = EXPR_CONST, .arg = val }, 1);
+	}
+
+	char name[8];
+	size_t len = 0;
+	while (isalnum((unsigned char)ps->p[len]) && len < sizeof(name)-1) {
+		name[len] = tolower((unsigned char)ps->p[len]);
+		len++;
+	}
+	name[len] = '\0';
+	if (!len)
+		return -1;
+	ps->p += len;
+
+	if (!strcmp(name, "byte") || !strcmp(name, "word")) {
+		if (!accept(ps, "["))
+			return -1;
+		return parse_load(ps, name[0] == 'w' ? 2 : 1);
+	}
+	for (size_t i = 0; i < sizeof(regs)/sizeof(*regs); i++) {
+		if (!strcmp(name, regs[i].name))
+			return emit(ps, (struct expr_insn){ .op = EXPR_REG, .arg = i }, 1);
+	}
+	return -1;
+}
+
+static int parse_unary(struct parser *ps) {
+	if (accept(ps, "-")) {
+		if (parse_unary(ps) == -1)
+			return -1;
+		return emit(ps, (struct expr_insn){ .op = EXPR_NEG }, 0);
+	}
+	if (accept(ps, "~")) {
+		if (parse_unary(ps) == -1)
+			return -1;
+		return emit(ps, (struct expr_insn){ .op = EXPR_NOT }, 0);
+	}
+	return parse_primary(ps);
+}
+
+struct binop {
+	const char *tok;
+	enum expr_op op;
+};
+
+// one level of left-associative binary operators
+static int parse_binary(struct parser *ps, const struct binop *ops, size_t num_ops,
+		int (*operand)(struct parser *ps)) {
+	if (operand(ps) == -1)
+		return -1;
+	for (;;) {
+		size_t i;
+		for (i = 0; i < num_ops; i++) {
+			if (accept(ps, ops[i].tok))
+				break;
+		}
+		if (i == num_ops)
+			return 0;
+		if (operand(ps) == -1 || emit(ps, (struct expr_insn){ .op = ops[i].op }, -1) == -1)
+			return -1;
+	}
+}
+
+static int parse_mul(struct parser *ps) {
+	static const struct binop ops[] = { { "*", EXPR_MUL } };
+	return parse_binary(ps, ops, 1, parse_unary);
+}
+
+static int parse_add(struct parser *ps) {
+	static const struct binop ops[] = { { "+", EXPR_ADD }, { "-", EXPR_SUB } };
+	return parse_binary(ps, ops, 2, parse_mul);
+}
+
+static int parse_shift(struct parser *ps) {
+	static const struct binop ops[] = { { "<<", EXPR_SHL }, { ">>", EXPR_SHR } };
+	return parse_binary(ps, ops, 2, parse_add);
+}
+
+static int parse_and(struct parser *ps) {
+	static const struct binop ops[] = { { "&", EXPR_AND } };
+	return parse_binary(ps, ops, 1, parse_shift);
+}
+
+static int parse_xor(struct parser *ps) {
+	static const struct binop ops[] = { { "^", EXPR_XOR } };
+	return parse_binary(ps, ops, 1, parse_and);
+}
+
+static int parse_or(struct parser *ps) {
+	static const struct binop ops[] = { { "|", EXPR_OR } };
+	return parse_binary(ps, ops, 1, parse_xor);
+}
+
+int expr_compile(const char *str, struct expr *expr) {
+	struct parser ps = { .p = str, .expr = expr };
+	expr->len = 0;
+	expr->num_loads = 0;
+	if (parse_or(&ps) == -1)
+		return -1;
+	skip_space(&ps);
+	return *ps.p ? -1 : 0;
+}
+
+void expr_reset_loads(const struct expr *expr, struct expr_load *loads) {
+	for (uint32_t i = 0; i < expr->num_loads; i++)
+		loads[i].state = EXPR_LOAD_NONE;
+}
+
+// returns true if the value is known. otherwise, the loads whose addresses became known are
+// left as EXPR_LOAD_WANTED; once their values are filled in and marked EXPR_LOAD_DONE, the
+// next evaluation gets further. `cpu_regs` is indexed by enum cpu_reg.
+bool expr_eval(const struct expr *expr, const uint32_t *cpu_regs, struct expr_load *loads,
+		uint32_t *val) {
+	uint32_t stack[EXPR_MAX_STACK];
+	bool known[EXPR_MAX_STACK];
+	int sp = 0;
+
+	for (uint32_t i = 0; i < expr->len; i++) {
+		const struct expr_insn *insn = &expr->code[i];
+		uint32_t a = sp > 1 ? stack[sp-2] : 0, b = sp > 0 ? stack[sp-1] : 0;
+		switch (insn->op) {
+			case EXPR_CONST:
+				known[sp] = true;
+				stack[sp++] = insn->arg;
+				continue;
+			case EXPR_REG:
+				known[sp] = true;
+				stack[sp++] = cpu_regs[regs[insn->arg].reg] >> regs[insn->arg].shift &
+					regs[insn->arg].mask;
+				continue;
+			case EXPR_LOAD: {
+				struct expr_load *load = &loads[insn->slot];
+				if (!known[sp-1])
+					continue;
+				b &= 0xffff;
+				if (load->state == EXPR_LOAD_DONE && load->addr == b) {
+					stack[sp-1] = load->val;
+					continue;
+				}
+				load->state = EXPR_LOAD_WANTED;
+				load->addr = b;
+				load->size = insn->size;
+				known[sp-1] = false;
+				continue;
+			}
+			case EXPR_NEG:
+				stack[sp-1] = -b;
+				continue;
+			case EXPR_NOT:
+				stack[sp-1] = ~b;
+				continue;
+		}
+
+		// binary operators
+		sp--;
+		known[sp-1] = known[sp-1] && known[sp];
+		switch (insn->op) {
+			case EXPR_ADD: stack[sp-1] = a + b; break;
+			case EXPR_SUB: stack[sp-1] = a - b; break;
+			case EXPR_MUL: stack[sp-1] = a * b; break;
+			case EXPR_AND: stack[sp-1] = a & b; break;
+			case EXPR_OR: stack[sp-1] = a | b; break;
+			case EXPR_XOR: stack[sp-1] = a ^ b; break;
+			case EXPR_SHL: stack[sp-1] = b < 32 ? a << b : 0; break;
+			case EXPR_SHR: stack[sp-1] = b < 32 ? a >> b : 0; break;
+		}
+	}
+	*val = stack[0];
+	return known[0];
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef EXPR_H
+#define EXPR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define EXPR_MAX_CODE 64
+#define EXPR_MAX_LOADS 8
+
+// expressions are compiled once into a small stack program. memory operands ([addr] for a
+// byte, word [addr] for a little-endian word) don't read anything themselves: evaluating
+// leaves their addresses in the load slots, so the caller can fetch the loads of many
+// expressions together and evaluate again.
+enum expr_op {
+	EXPR_CONST,
+	EXPR_REG,
+	EXPR_LOAD,
+	EXPR_NEG,
+	EXPR_NOT,
+	EXPR_ADD,
+	EXPR_SUB,
+	EXPR_MUL,
+	EXPR_AND,
+	EXPR_OR,
+	EXPR_XOR,
+	EXPR_SHL,
+	EXPR_SHR,
+};
+
+struct expr_insn {
+	uint8_t op;
+	uint8_t size; // of a load, in bytes
+	uint8_t slot; // of a load
+	uint32_t arg; // a constant, or an index into the register table
+};
+
+struct expr {
+	struct expr_insn code[EXPR_MAX_CODE];
+	uint32_t len;
+	uint32_t num_loads;
+};
+
+enum expr_load_state {
+	EXPR_LOAD_NONE, // the address isn't known yet
+	EXPR_LOAD_WANTED, // the address is known and the value must be fetched
+	EXPR_LOAD_DONE,
+};
+
+struct expr_load {
+	enum expr_load_state state;
+	uint32_t addr;
+	uint32_t size;
+	uint32_t val;
+};
+
+int expr_compile(const char *str, struct expr *expr);
+void expr_reset_loads(const struct expr *expr, struct expr_load *loads);
+bool expr_eval(const struct expr *expr, const uint32_t *cpu_regs, struct expr_load *loads,
+		uint32_t *val);
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "ipclog.h"
+
+static FILE *capture;
+static struct timespec start;
+
+int ipclog_open(const char *path) {
+	if (!(capture = fopen(path, "wb"))) {
+		perror("fopen()");
+		return -1;
+	}
+
+	struct ipclog_header hdr = { .magic = IPCLOG_MAGIC, .version = IPCLOG_VERSION };
+	if (fwrite(&hdr, sizeof(hdr), 1, capture) != 1) {
+		perror("fwrite()");
+		fclose(capture);
+		capture = NULL;
+		return -1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	return 0;
+}
+
+void ipclog_close() {
+	if (capture) {
+		fclose(capture);
+		capture = NULL;
+	}
+}
+
+bool ipclog_is_open() {
+	return capture;
+}
+
+void ipclog_write(enum ipclog_dir dir, const struct msg *msg) {
+	if (!capture)
+		return;
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	struct ipclog_record rec = {
+		.time_ns = (now.tv_sec - start.tv_sec) * 1000000000ull + now.tv_nsec - start.tv_nsec,
+		.dir = dir,
+		.type = msg->hdr.type,
+		.subtype = msg->hdr.subtype.inspect,
+		.size = msg->payload ? msg->hdr.size : 0,
+	};
+	// records go through stdio's buffer; a capture costs no syscall per message
+	fwrite(&rec, sizeof(rec), 1, capture);
+	if (rec.size)
+		fwrite(msg->payload, rec.size, 1, capture);
+}
+
+int ipclog_read_header(FILE *f) {
+	struct ipclog_header hdr;
+	if (fread(&hdr, sizeof(hdr), 1, f) != 1)
+		return -1;
+	if (hdr.magic != IPCLOG_MAGIC || hdr.version != IPCLOG_VERSION)
+		return -1;
+	return 0;
+}
+
+// returns 1 on a record, 0 at the end of the capture and -1 on errors. the caller owns
+// msg->payload.
+int ipclog_read(FILE *f, struct ipclog_record *rec, struct msg *msg) {
+	if (fread(rec, sizeof(*rec), 1, f) != 1)
+		return feof(f) ? 0 : -1;
+
+	*msg = (struct msg){};
+	msg->hdr.type = rec->type;
+	msg->hdr.subtype.inspect = rec->subtype;
+	msg->hdr.size = rec->size;
+	if (rec->size) {
+		if (!(msg->payload = malloc(rec->size))) {
+			perror("malloc()");
+			return -1;
+		}
+		if (fread(msg->payload, rec->size, 1, f) != 1) {
+			free(msg->payload);
+			msg->payload = NULL;
+			return -1;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef IPCLOG_H
+#define IPCLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <libemu.h>
+
+// a capture is a header followed by one record per message, each record followed by its
+// payload. integers are stored in host byte order.
+#define IPCLOG_MAGIC 0x43504952 // "RIPC"
+#define IPCLOG_VERSION 1
+
+enum ipclog_dir {
+	IPCLOG_SENT, // monitor to emulator
+	IPCLOG_RECV, // emulator to monitor
+};
+
+struct ipclog_header {
+	uint32_t magic;
+	uint32_t version;
+};
+
+struct ipclog_record {
+	uint64_t time_ns; // since the capture was opened
+	uint32_t dir;
+	uint32_t type;
+	uint32_t subtype;
+	uint32_t size;
+};
+
+int ipclog_open(const char *path);
+void ipclog_close();
+bool ipclog_is_open();
+void ipclog_write(enum ipclog_dir dir, const struct msg *msg);
+
+int ipclog_read_header(FILE *f);
+int ipclog_read(FILE *f, struct ipclog_record *rec, struct msg *msg);
+
+#endif
@@ -16,11 +16,44 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
+#include <getopt.h>
+#include <stdio.h>
+
 #include "client.h"
+#include "ipclog.h"
 #include "tui/tui.h"
 
+static void usage(const char *prog) {
+	fprintf(stderr, "usage: %s [--shm] [--record-ipc <file>]\n", prog);
+}
+
 int main(int argc, char **argv)
 {
+	static const struct option options[] = {
+		{ "shm", no_argument, NULL, 's' },
+		{ "record-ipc", required_argument, NULL, 'r' },
+		{ 0 }
+	};
+	bool use_shm = false;
+	const char *capture = NULL;
+	int opt;
+	while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+		switch (opt) {
+			case 's':
+				use_shm = true;
+				break;
+			case 'r':
+				capture = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return -1;
+		}
+	}
+
+	if (capture && ipclog_open(capture) == -1)
+		return -1;
+
 	struct dispatch_table *disp;
 	if ((disp = tui_init()) == NULL) {
 		goto err;
@@ -28,6 +61,9 @@ int main(int argc, char **argv)
 	if (client_init(disp) == -1) {
 		goto err;
 	}
+	// bulk reads fall back to the socket if the server can't share its memory
+	if (use_shm)
+		client_map_shm();
 	tui_run();
 	return 0;
 err:
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+
+#define PROFILE_MIN_SLOTS 4096
+
+// one counter per address, in an open addressing table that doubles when half full. samples
+// are aggregated as they come, so nothing else is stored.
+struct profile_slot {
+	uint32_t addr;
+	uint32_t count; // 0 for a free slot
+};
+
+static struct {
+	struct profile_slot *slots;
+	size_t num_slots; // a power of two
+	size_t num_used;
+	uint64_t total;
+	uint32_t rate;
+	bool enabled;
+} prof;
+
+void profile_start(uint32_t rate) {
+	prof.rate = rate ? rate : PROFILE_DEFAULT_RATE;
+	prof.enabled = true;
+}
+
+void profile_stop() {
+	prof.enabled = false;
+}
+
+void profile_clear() {
+	if (prof.slots)
+		memset(prof.slots, 0, prof.num_slots * sizeof(*prof.slots));
+	prof.num_used = 0;
+	prof.total = 0;
+}
+
+bool profile_is_enabled() {
+	return prof.enabled;
+}
+
+uint32_t profile_get_rate() {
+	return prof.rate;
+}
+
+// the slot of `addr`, or the free one where it would go
+static struct profile_slot *find_slot(uint32_t addr) {
+	if (!prof.num_slots)
+		return NULL;
+	size_t mask = prof.num_slots-1;
+	size_t i = (addr * 2654435761u) & mask;
+	while (prof.slots[i].count && prof.slots[i].addr != addr)
+		i = (i+1) & mask;
+	return &prof.slots[i];
+}
+
+static int grow() {
+	size_t num_slots = prof.num_slots ? prof.num_slots*2 : PROFILE_MIN_SLOTS;
+	struct profile_slot *slots = calloc(num_slots, sizeof(*slots));
+	if (!slots) {
+		perror("calloc()");
+		return -1;
+	}
+
+	struct profile_slot *old_slots = prof.slots;
+	size_t old_num_slots = prof.num_slots;
+	prof.slots = slots;
+	prof.num_slots = num_slots;
+	for (size_t i = 0; i < old_num_slots; i++) {
+		if (old_slots[i].count)
+			*find_slot(old_slots[i].addr) = old_slots[i];
+	}
+	free(old_slots);
+	return 0;
+}
+
+// `addr` is banked for code in the switchable rom area, so each bank is counted apart
+void profile_add_sample(uint32_t addr) {
+	if (2*(prof.num_used+1) > prof.num_slots && grow() == -1)
+		return;
+	struct profile_slot *slot = find_slot(addr);
+	if (!slot->count) {
+		slot->addr = addr;
+		prof.num_used++;
+	}
+	slot->count++;
+	prof.total++;
+}
+
+uint64_t profile_get_total() {
+	return prof.total;
+}
+
+uint32_t profile_get_count(uint32_t addr) {
+	const struct profile_slot *slot = find_slot(addr);
+	return slot ? slot->count : 0;
+}
+
+double profile_get_percent(uint32_t addr) {
+	if (!prof.total)
+		return 0;
+	return profile_get_count(addr) * 100.0 / prof.total;
+}
+
+// fills `addrs` with the (at most n) hottest addresses, hottest first
+size_t profile_get_top(uint32_t *addrs, size_t n) {
+	uint32_t counts[PROFILE_MAX_TOP];
+	size_t num_top = 0;
+	if (n > PROFILE_MAX_TOP)
+		n = PROFILE_MAX_TOP;
+
+	for (size_t slot = 0; slot < prof.num_slots && n; slot++) {
+		uint32_t count = prof.slots[slot].count;
+		if (!count || (num_top == n && count <= counts[n-1]))
+			continue;
+
+		// insertion into the short sorted list
+		size_t i = num_top < n ? num_top++ : n-1;
+		while (i > 0 && counts[i-1] < count) {
+			addrs[i] = addrs[i-1];
+			counts[i] = counts[i-1];
+			i--;
+		}
+		addrs[i] = prof.slots[slot].addr;
+		counts[i] = count;
+	}
+
+	return num_top;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define PROFILE_DEFAULT_RATE 500 // samples per second
+#define PROFILE_MAX_TOP 64
+
+void profile_start(uint32_t rate);
+void profile_stop();
+void profile_clear();
+bool profile_is_enabled();
+uint32_t profile_get_rate();
+
+void profile_add_sample(uint32_t addr);
+uint64_t profile_get_total();
+uint32_t profile_get_count(uint32_t addr);
+double profile_get_percent(uint32_t addr);
+size_t profile_get_top(uint32_t *addrs, size_t n);
+
+#endif
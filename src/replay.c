@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// plays a capture made with --record-ipc back to a monitor, standing in for the emulator.
+// messages the monitor sends are checked against the capture, and the emulator's messages
+// are sent back in their recorded order, so a session reruns the same way without RealBoy
+// or a ROM.
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libemu.h>
+
+#include "ipclog.h"
+
+static void usage(const char *prog) {
+	fprintf(stderr, "usage: %s [--realtime] <capture>\n", prog);
+}
+
+static uint64_t elapsed_ns(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000000000ull + now.tv_nsec - start->tv_nsec;
+}
+
+static bool same_msg(const struct msg *a, const struct msg *b) {
+	if (a->hdr.type != b->hdr.type || a->hdr.subtype.inspect != b->hdr.subtype.inspect)
+		return false;
+	uint32_t size_a = a->payload ? a->hdr.size : 0, size_b = b->payload ? b->hdr.size : 0;
+	return size_a == size_b && (!size_a || !memcmp(a->payload, b->payload, size_a));
+}
+
+int main(int argc, char **argv) {
+	static const struct option options[] = {
+		{ "realtime", no_argument, NULL, 'r' },
+		{ 0 }
+	};
+	// by default messages are sent as soon as the monitor is ready for them, which is what
+	// a benchmark wants; --realtime keeps the recorded gaps
+	bool realtime = false;
+	int opt;
+	while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+		switch (opt) {
+			case 'r':
+				realtime = true;
+				break;
+			default:
+				usage(argv[0]);
+				return -1;
+		}
+	}
+	if (optind != argc-1) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	FILE *f = fopen(argv[optind], "rb");
+	if (!f) {
+		perror("fopen()");
+		return -1;
+	}
+	if (ipclog_read_header(f) == -1) {
+		fprintf(stderr, "%s: not a capture\n", argv[optind]);
+		goto err;
+	}
+	if (emu_init(true) == -1)
+		goto err;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	size_t num_msgs = 0, num_mismatches = 0, first_mismatch = 0;
+	struct ipclog_record rec;
+	struct msg msg;
+	int ret;
+	while ((ret = ipclog_read(f, &rec, &msg)) == 1) {
+		if (rec.type == TYPE_MONITOR && rec.subtype == MONITOR_MAP_SHM) {
+			// the fd that followed this message can't be replayed
+			fprintf(stderr, "capture uses shared memory; record it without --shm\n");
+			free(msg.payload);
+			goto err;
+		}
+
+		if (rec.dir == IPCLOG_SENT) {
+			struct msg got = {};
+			if (emu_recv_msg(&got, true) == -1) {
+				free(msg.payload);
+				fprintf(stderr, "monitor went away after %zu messages\n", num_msgs);
+				goto err;
+			}
+			if (!same_msg(&got, &msg) && !num_mismatches++)
+				first_mismatch = num_msgs;
+			free(got.payload);
+		}
+		else {
+			if (realtime) {
+				uint64_t now = elapsed_ns(&start);
+				if (rec.time_ns > now) {
+					uint64_t wait = rec.time_ns - now;
+					struct timespec ts = { .tv_sec = wait / 1000000000, .tv_nsec = wait % 1000000000 };
+					nanosleep(&ts, NULL);
+				}
+			}
+			if (emu_send_msg(&msg) == -1) {
+				free(msg.payload);
+				fprintf(stderr, "monitor went away after %zu messages\n", num_msgs);
+				goto err;
+			}
+		}
+		free(msg.payload);
+		num_msgs++;
+	}
+	if (ret == -1) {
+		fprintf(stderr, "%s: truncated capture\n", argv[optind]);
+		goto err;
+	}
+
+	printf("%zu messages in %.3f s\n", num_msgs, elapsed_ns(&start) / 1e9);
+	if (num_mismatches)
+		printf("%zu requests differ from the capture, first at message %zu\n",
+				num_mismatches, first_mismatch);
+
+	fclose(f);
+	return num_mismatches ? 1 : 0;
+err:
+	fclose(f);
+	return -1;
+}
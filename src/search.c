@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SEARCH_X86
+#endif
+
+#include "disasm.h"
+#include "search.h"
+
+static int hex_nibble(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c = tolower(c);
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+// each token holds one or more bytes in hex, e.g. "3e", "0x3e10" or "??" for a wildcard
+int search_parse_bytes(struct search_pattern *pat, int argc, char *const *argv) {
+	bool anchored = false;
+
+	pat->len = 0;
+	for (int i = 0; i < argc; i++) {
+		const char *str = argv[i];
+		if (str[0] == '0' && str[1] == 'x')
+			str += 2;
+
+		size_t len = strlen(str);
+		if (!len || len % 2)
+			return -1;
+		for (size_t j = 0; j < len; j += 2) {
+			if (pat->len == SEARCH_MAX_PATTERN)
+				return -1;
+			if (str[j] == '?' && str[j+1] == '?') {
+				pat->wild[pat->len] = true;
+				pat->bytes[pat->len++] = 0;
+				continue;
+			}
+			int hi = hex_nibble(str[j]), lo = hex_nibble(str[j+1]);
+			if (hi == -1 || lo == -1)
+				return -1;
+			pat->wild[pat->len] = false;
+			pat->bytes[pat->len++] = hi << 4 | lo;
+			anchored = true;
+		}
+	}
+
+	// a pattern made only of wildcards matches everywhere; refuse it
+	return anchored ? 0 : -1;
+}
+
+struct scan {
+	const uint8_t *buf;
+	const struct search_pattern *pat;
+	size_t first, last; // offsets of the first and last non-wildcard bytes
+	uint32_t *hits;
+	size_t max_hits;
+	size_t num_hits;
+};
+
+static void scan_verify(struct scan *s, size_t pos) {
+	const uint8_t *p = s->buf + pos;
+	for (size_t i = s->first+1; i < s->last; i++) {
+		if (!s->pat->wild[i] && p[i] != s->pat->bytes[i])
+			return;
+	}
+	if (s->num_hits < s->max_hits)
+		s->hits[s->num_hits] = pos;
+	s->num_hits++;
+}
+
+static size_t scan_scalar(struct scan *s, size_t pos, size_t end) {
+	uint8_t first = s->pat->bytes[s->first], last = s->pat->bytes[s->last];
+	for (; pos < end; pos++) {
+		if (s->buf[pos+s->first] == first && s->buf[pos+s->last] == last)
+			scan_verify(s, pos);
+	}
+	return pos;
+}
+
+#ifdef SEARCH_X86
+// the vectorized loops compare the first and last fixed bytes of the pattern at 16 (or 32)
+// candidate positions at once; only positions where both match are verified byte by byte.
+static size_t scan_sse2(struct scan *s, size_t pos, size_t end) {
+	const __m128i first = _mm_set1_epi8((char)s->pat->bytes[s->first]);
+	const __m128i last = _mm_set1_epi8((char)s->pat->bytes[s->last]);
+	for (; pos + 16 <= end; pos += 16) {
+		__m128i f = _mm_loadu_si128((const __m128i *)(s->buf + pos + s->first));
+		__m128i l = _mm_loadu_si128((const __m128i *)(s->buf + pos + s->last));
+		uint32_t mask = _mm_movemask_epi8(
+				_mm_and_si128(_mm_cmpeq_epi8(f, first), _mm_cmpeq_epi8(l, last)));
+		while (mask) {
+			scan_verify(s, pos + __builtin_ctz(mask));
+			mask &= mask - 1;
+		}
+	}
+	return pos;
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(struct scan *s, size_t pos, size_t end) {
+	const __m256i first = _mm256_set1_epi8((char)s->pat->bytes[s->first]);
+	const __m256i last = _mm256_set1_epi8((char)s->pat->bytes[s->last]);
+	for (; pos + 32 <= end; pos += 32) {
+		__m256i f = _mm256_loadu_si256((const __m256i *)(s->buf + pos + s->first));
+		__m256i l = _mm256_loadu_si256((const __m256i *)(s->buf + pos + s->last));
+		uint32_t mask = _mm256_movemask_epi8(
+				_mm256_and_si256(_mm256_cmpeq_epi8(f, first), _mm256_cmpeq_epi8(l, last)));
+		while (mask) {
+			scan_verify(s, pos + __builtin_ctz(mask));
+			mask &= mask - 1;
+		}
+	}
+	return pos;
+}
+#endif
+
+size_t search_bytes(const uint8_t *buf, size_t size, const struct search_pattern *pat,
+		uint32_t *hits, size_t max_hits) {
+	struct scan s = { .buf = buf, .pat = pat, .hits = hits, .max_hits = max_hits };
+	if (!pat->len || size < pat->len)
+		return 0;
+
+	while (pat->wild[s.first])
+		s.first++;
+	s.last = pat->len-1;
+	while (pat->wild[s.last])
+		s.last--;
+
+	size_t end = size - pat->len + 1, pos = 0;
+#ifdef SEARCH_X86
+	if (__builtin_cpu_supports("avx2"))
+		pos = scan_avx2(&s, pos, end);
+	pos = scan_sse2(&s, pos, end);
+#endif
+	scan_scalar(&s, pos, end);
+
+	return s.num_hits;
+}
+
+// '*' matches any run of characters and '?' any single one
+static bool glob_match(const char *pat, const char *str) {
+	const char *star = NULL, *retry = NULL;
+	while (*str) {
+		if (*pat == '*') {
+			star = pat++;
+			retry = str;
+		}
+		else if (*pat == '?' || *pat == *str) {
+			pat++;
+			str++;
+		}
+		else if (star) {
+			pat = star+1;
+			str = ++retry;
+		}
+		else {
+			return false;
+		}
+	}
+	while (*pat == '*')
+		pat++;
+	return !*pat;
+}
+
+enum {
+	FILTER_NEVER,
+	FILTER_ALWAYS,
+	FILTER_DECODE,
+};
+
+// decide once per opcode whether the template can match, so most offsets are rejected
+// without formatting any text.
+static uint8_t filter_template(const char *pat, const char *template) {
+	const char *fmt = strchr(template, '%');
+	if (!fmt)
+		return glob_match(pat, template) ? FILTER_ALWAYS : FILTER_NEVER;
+
+	size_t len = fmt - template;
+	for (size_t i = 0; i < len && pat[i] && pat[i] != '*'; i++) {
+		if (pat[i] != '?' && pat[i] != template[i])
+			return FILTER_NEVER;
+	}
+	return FILTER_DECODE;
+}
+
+size_t search_instrs(const uint8_t *buf, size_t size, const char *pattern,
+		uint32_t *hits, size_t max_hits) {
+	char pat[128];
+	size_t i;
+	for (i = 0; pattern[i] && i < sizeof(pat)-1; i++)
+		pat[i] = tolower(pattern[i]);
+	pat[i] = '\0';
+
+	uint8_t filter[256], filter_cb[256];
+	for (i = 0; i < 256; i++) {
+		uint8_t op[2] = { i, 0 };
+		uint8_t op_cb[2] = { 0xcb, i };
+		filter[i] = filter_template(pat, disasm_template(op));
+		filter_cb[i] = filter_template(pat, disasm_template(op_cb));
+	}
+
+	size_t num_hits = 0;
+	for (size_t pos = 0; pos < size; pos++) {
+		uint8_t op = buf[pos];
+		if (pos + disasm_op_len(op) > size)
+			continue;
+
+		uint8_t f = op == 0xcb ? filter_cb[buf[pos+1]] : filter[op];
+		if (f == FILTER_NEVER)
+			continue;
+		if (f == FILTER_DECODE) {
+			char text[64];
+			disasm_bytes(&buf[pos], text, sizeof(text));
+			if (!glob_match(pat, text))
+				continue;
+		}
+
+		if (num_hits < max_hits)
+			hits[num_hits] = pos;
+		num_hits++;
+	}
+
+	return num_hits;
+}
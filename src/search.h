@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define SEARCH_MAX_PATTERN 64
+
+struct search_pattern {
+	uint8_t bytes[SEARCH_MAX_PATTERN];
+	bool wild[SEARCH_MAX_PATTERN];
+	size_t len;
+};
+
+int search_parse_bytes(struct search_pattern *pat, int argc, char *const *argv);
+
+// both searches store at most `max_hits` offsets into `hits`, but return the total number of hits
+size_t search_bytes(const uint8_t *buf, size_t size, const struct search_pattern *pat,
+		uint32_t *hits, size_t max_hits);
+size_t search_instrs(const uint8_t *buf, size_t size, const char *pattern,
+		uint32_t *hits, size_t max_hits);
+
+#endif
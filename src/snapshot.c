@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SNAPSHOT_X86
+#endif
+
+#include "snapshot.h"
+
+#define CANDIDATE_WORDS (SNAPSHOT_SIZE/64)
+
+// two snapshots are kept and used in turns; the candidate set is a bitmap over the address space
+static struct {
+	uint8_t mem[2][SNAPSHOT_SIZE];
+	int curr;
+	uint64_t candidates[CANDIDATE_WORDS];
+	bool taken;
+} snap;
+
+static size_t count_candidates() {
+	size_t count = 0;
+	for (size_t i = 0; i < CANDIDATE_WORDS; i++)
+		count += __builtin_popcountll(snap.candidates[i]);
+	return count;
+}
+
+#ifndef SNAPSHOT_X86
+static void narrow_scalar(const uint8_t *prev, const uint8_t *curr, enum snapshot_op op,
+		uint8_t value) {
+	for (size_t i = 0; i < CANDIDATE_WORDS; i++) {
+		uint64_t cand = snap.candidates[i];
+		if (!cand)
+			continue;
+
+		uint64_t mask = 0;
+		for (size_t j = 0; j < 64; j++) {
+			uint8_t a = prev[i*64+j], b = curr[i*64+j];
+			bool keep;
+			switch (op) {
+				case SNAPSHOT_CHANGED: keep = a != b; break;
+				case SNAPSHOT_UNCHANGED: keep = a == b; break;
+				case SNAPSHOT_INCREASED: keep = b > a; break;
+				case SNAPSHOT_DECREASED: keep = b < a; break;
+				default: keep = b == value; break;
+			}
+			mask |= (uint64_t)keep << j;
+		}
+		snap.candidates[i] = cand & mask;
+	}
+}
+#else
+// there is no unsigned byte comparison in SSE2/AVX2, so both operands are biased by 0x80 and
+// compared as signed bytes.
+static inline __m128i cmp_sse2(__m128i a, __m128i b, __m128i value, enum snapshot_op op) {
+	const __m128i bias = _mm_set1_epi8((char)0x80);
+	switch (op) {
+		case SNAPSHOT_CHANGED:
+			return _mm_xor_si128(_mm_cmpeq_epi8(a, b), _mm_set1_epi8(-1));
+		case SNAPSHOT_UNCHANGED:
+			return _mm_cmpeq_epi8(a, b);
+		case SNAPSHOT_INCREASED:
+			return _mm_cmpgt_epi8(_mm_xor_si128(b, bias), _mm_xor_si128(a, bias));
+		case SNAPSHOT_DECREASED:
+			return _mm_cmpgt_epi8(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+		default:
+			return _mm_cmpeq_epi8(b, value);
+	}
+}
+
+static void narrow_sse2(const uint8_t *prev, const uint8_t *curr, enum snapshot_op op,
+		uint8_t value) {
+	const __m128i v = _mm_set1_epi8((char)value);
+	for (size_t i = 0; i < CANDIDATE_WORDS; i++) {
+		uint64_t cand = snap.candidates[i];
+		if (!cand)
+			continue;
+
+		uint64_t mask = 0;
+		for (size_t j = 0; j < 64; j += 16) {
+			__m128i a = _mm_loadu_si128((const __m128i *)&prev[i*64+j]);
+			__m128i b = _mm_loadu_si128((const __m128i *)&curr[i*64+j]);
+			mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(cmp_sse2(a, b, v, op)) << j;
+		}
+		snap.candidates[i] = cand & mask;
+	}
+}
+
+__attribute__((target("avx2")))
+static inline __m256i cmp_avx2(__m256i a, __m256i b, __m256i value, enum snapshot_op op) {
+	const __m256i bias = _mm256_set1_epi8((char)0x80);
+	switch (op) {
+		case SNAPSHOT_CHANGED:
+			return _mm256_xor_si256(_mm256_cmpeq_epi8(a, b), _mm256_set1_epi8(-1));
+		case SNAPSHOT_UNCHANGED:
+			return _mm256_cmpeq_epi8(a, b);
+		case SNAPSHOT_INCREASED:
+			return _mm256_cmpgt_epi8(_mm256_xor_si256(b, bias), _mm256_xor_si256(a, bias));
+		case SNAPSHOT_DECREASED:
+			return _mm256_cmpgt_epi8(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+		default:
+			return _mm256_cmpeq_epi8(b, value);
+	}
+}
+
+__attribute__((target("avx2")))
+static void narrow_avx2(const uint8_t *prev, const uint8_t *curr, enum snapshot_op op,
+		uint8_t value) {
+	const __m256i v = _mm256_set1_epi8((char)value);
+	for (size_t i = 0; i < CANDIDATE_WORDS; i++) {
+		uint64_t cand = snap.candidates[i];
+		if (!cand)
+			continue;
+
+		uint64_t mask = 0;
+		for (size_t j = 0; j < 64; j += 32) {
+			__m256i a = _mm256_loadu_si256((const __m256i *)&prev[i*64+j]);
+			__m256i b = _mm256_loadu_si256((const __m256i *)&curr[i*64+j]);
+			mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(cmp_avx2(a, b, v, op)) << j;
+		}
+		snap.candidates[i] = cand & mask;
+	}
+}
+#endif
+
+uint8_t *snapshot_get_buffer() {
+	return snap.mem[snap.curr ^ 1];
+}
+
+size_t snapshot_reset() {
+	snap.curr ^= 1;
+	snap.taken = true;
+	memset(snap.candidates, 0xff, sizeof(snap.candidates));
+	return SNAPSHOT_SIZE;
+}
+
+size_t snapshot_narrow(enum snapshot_op op, uint8_t value) {
+	if (!snap.taken)
+		return snapshot_reset();
+
+	const uint8_t *prev = snap.mem[snap.curr], *curr = snap.mem[snap.curr ^ 1];
+#ifdef SNAPSHOT_X86
+	if (__builtin_cpu_supports("avx2"))
+		narrow_avx2(prev, curr, op, value);
+	else
+		narrow_sse2(prev, curr, op, value);
+#else
+	narrow_scalar(prev, curr, op, value);
+#endif
+	snap.curr ^= 1;
+
+	return count_candidates();
+}
+
+bool snapshot_is_taken() {
+	return snap.taken;
+}
+
+// returns SNAPSHOT_SIZE when there are no candidates left at or after `addr`
+uint32_t snapshot_next_candidate(uint32_t addr) {
+	while (addr < SNAPSHOT_SIZE) {
+		uint64_t word = snap.candidates[addr/64] >> (addr % 64);
+		if (word)
+			return addr + __builtin_ctzll(word);
+		addr = (addr/64 + 1) * 64;
+	}
+	return SNAPSHOT_SIZE;
+}
+
+uint8_t snapshot_get_prev(uint32_t addr) {
+	return snap.mem[snap.curr ^ 1][addr];
+}
+
+uint8_t snapshot_get_curr(uint32_t addr) {
+	return snap.mem[snap.curr][addr];
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define SNAPSHOT_SIZE 0x10000
+
+enum snapshot_op {
+	SNAPSHOT_CHANGED,
+	SNAPSHOT_UNCHANGED,
+	SNAPSHOT_INCREASED,
+	SNAPSHOT_DECREASED,
+	SNAPSHOT_EQUAL,
+};
+
+// fill the returned buffer with the memory contents, then commit it with either
+// snapshot_reset() or snapshot_narrow()
+uint8_t *snapshot_get_buffer();
+size_t snapshot_reset();
+size_t snapshot_narrow(enum snapshot_op op, uint8_t value);
+
+bool snapshot_is_taken();
+uint32_t snapshot_next_candidate(uint32_t addr);
+uint8_t snapshot_get_prev(uint32_t addr);
+uint8_t snapshot_get_curr(uint32_t addr);
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#include <string.h>
+
+#include "trace.h"
+
+// ring buffer keeping the newest TRACE_MAX_RECORDS executed instructions
+static struct {
+	struct trace_record records[TRACE_MAX_RECORDS];
+	size_t num_records;
+} trace;
+
+void trace_clear() {
+	trace.num_records = 0;
+}
+
+void trace_add(uint32_t pc, const uint8_t *bytes) {
+	struct trace_record *rec = &trace.records[trace.num_records++ % TRACE_MAX_RECORDS];
+	rec->pc = pc;
+	memcpy(rec->bytes, bytes, sizeof(rec->bytes));
+}
+
+size_t trace_get_count() {
+	return trace.num_records < TRACE_MAX_RECORDS ? trace.num_records : TRACE_MAX_RECORDS;
+}
+
+// 0 is the oldest record kept
+const struct trace_record *trace_get(size_t i) {
+	size_t first = trace.num_records - trace_get_count();
+	return &trace.records[(first + i) % TRACE_MAX_RECORDS];
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TRACE_MAX_RECORDS 0x10000
+
+// one executed instruction. pcs in the switchable area are banked
+struct trace_record {
+	uint32_t pc;
+	uint8_t bytes[3];
+};
+
+void trace_clear();
+void trace_add(uint32_t pc, const uint8_t *bytes);
+size_t trace_get_count();
+const struct trace_record *trace_get(size_t i);
+
+#endif
@@ -17,74 +17,67 @@
  */
 
 #include <ctype.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "cli.h"
+#include "render.h"
+#include "results.h"
+#include "tplog.h"
+#include "tui.h"
+#include "vram.h"
+#include "watch.h"
 
+#include "callgraph.h"
+#include "cfg.h"
+#include "coverage.h"
 #include "client.h"
+#include "disasm.h"
+#include "profile.h"
+#include "search.h"
+#include "snapshot.h"
+#include "trace.h"
 
 struct cli_window wcli;
 
-#define CLI_MAX_INPUT_SIZE 256
+#define CLI_HISTORY_SIZE 32
 
-list_t *cmd_list;
+// commands that were entered, newest last; old entries are overwritten
+struct cli_history {
+	char entries[CLI_HISTORY_SIZE][CLI_MAX_INPUT_SIZE];
+	size_t num_entries;
+	size_t recall; // steps back from the newest entry; 0 is the line being edited
+};
+static struct cli_history history;
 
-static int str_command_get_argc_argv(const char *str, char ***argv) {
-	// how many arguments?
-	int num_args = 1;
-	for (size_t i = 0; i < strlen(str); i++) {
-		if (isblank(str[i]))
-			num_args++;
-		if (str[i] == '\0')
-			break;
-	}
-
-	*argv = malloc(num_args * sizeof(char *));
-	if (!*argv) {
-		perror("malloc()");
-		num_args = 0;
-		goto out;
-	}
-	char *last_ptr = str;
-	for (size_t i = 0, j = 0; i < strlen(str)+1; i++) {
-		if (isblank(str[i]) || str[i] == '\0') {
-			size_t size = (&str[i] - last_ptr);
-			char *ptr = malloc(size+1);
-			if (!ptr) {
-				perror("malloc()");
-				num_args = 0;
-				goto out;
-			}
-			strncpy(ptr, last_ptr, size);
-			ptr[size] = '\0';
-			(*argv)[j++] = ptr;
-			last_ptr = &str[i+1];
-		}
-	}
+// the command being executed; argv points into its own buffer, so nothing is allocated
+static struct cmd curr_cmd;
 
-out:
-	return num_args;
-}
+static int cmd_tokenize(struct cmd *cmd, const char *line) {
+	snprintf(cmd->buf, sizeof(cmd->buf), "%s", line);
+	cmd->argc = 0;
 
-// caller owns the allocation
-static struct cmd *new_cmd(const char *str) {
-	struct cmd *c = malloc(sizeof(*c));
-	if (!c) {
-		perror("malloc()");
-		goto out;
+	char *p = cmd->buf;
+	while (*p) {
+		while (isblank((unsigned char)*p))
+			*p++ = '\0';
+		if (!*p)
+			break;
+		if (cmd->argc == CLI_MAX_ARGS-1)
+			return -1;
+		cmd->argv[cmd->argc++] = p;
+		while (*p && !isblank((unsigned char)*p))
+			p++;
 	}
+	cmd->argv[cmd->argc] = NULL;
 
-	int argc;
-	char **argv;
-	argc = str_command_get_argc_argv(str, &argv);
-	c->argc = argc;
-	c->argv = argv;
-out:
-	return c;
+	return cmd->argc;
 }
 
-static char str[256] = {};
+static char str[CLI_MAX_INPUT_SIZE] = {};
 static int str_len = 0;
 
 void cli_redraw() {
@@ -101,79 +94,168 @@ void cli_redraw() {
 	}
 	wmove(wcli.win, wcli.current_pos_y, wcli.current_pos_x);
 	wborder(wcli.win, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
-	wrefresh(wcli.win);
+	render_mark(wcli.win);
+}
+
+void cli_printf(const char *fmt, ...) {
+	char buf[CLI_MAX_INPUT_SIZE];
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	// the output takes the line of the pending prompt, which is then redrawn below it
+	wmove(wcli.win, wcli.current_pos_y, 1);
+	wclrtoeol(wcli.win);
+	mvwaddnstr(wcli.win, wcli.current_pos_y, 1, buf, wcli.max_x-2);
+	wcli.current_pos_y++;
+	cli_redraw();
+}
+
+static void history_add(const char *line) {
+	history.recall = 0;
+	if (history.num_entries &&
+			!strcmp(history.entries[(history.num_entries-1) % CLI_HISTORY_SIZE], line))
+		return;
+	snprintf(history.entries[history.num_entries++ % CLI_HISTORY_SIZE], CLI_MAX_INPUT_SIZE,
+			"%s", line);
+}
+
+// replace the line being edited with `line`
+static void cli_set_input(const char *line) {
+	size_t start_x = strlen("> ")+1;
+
+	wmove(wcli.win, wcli.current_pos_y, start_x);
+	wclrtoeol(wcli.win);
+	snprintf(str, sizeof(str), "%s", line);
+	str_len = strlen(str);
+	mvwaddnstr(wcli.win, wcli.current_pos_y, start_x, str, wcli.max_x-start_x-1);
+	wcli.current_pos_x = start_x + str_len;
 }
 
-static void cli_parse(int ch, struct cmd **cmd_out) {
-	*cmd_out = NULL;
+static void history_recall(bool older) {
+	size_t num_entries = history.num_entries < CLI_HISTORY_SIZE ?
+		history.num_entries : CLI_HISTORY_SIZE;
 
-	if (str_len < 255 && (isalnum(ch) || isblank(ch))) {
+	if (older && history.recall < num_entries)
+		history.recall++;
+	else if (!older && history.recall > 0)
+		history.recall--;
+	else
+		return;
+
+	if (history.recall)
+		cli_set_input(history.entries[(history.num_entries-history.recall) % CLI_HISTORY_SIZE]);
+	else
+		cli_set_input("");
+}
+
+// returns true once a whole command line has been entered and tokenized into curr_cmd
+static bool cli_parse(int ch) {
+	bool has_cmd = false;
+
+	// with the keypad on, ch may also be a KEY_* code or ERR, which isprint can't take
+	if (str_len < CLI_MAX_INPUT_SIZE-1 && ch >= 0 && ch <= UCHAR_MAX && isprint(ch)) {
 		str[str_len++] = ch;
 		wcli.current_pos_x++;
 	}
 	else if (ch == '\n') {
-		struct cmd *c = {};
+		int argc = 0;
 		if (str_len) {
-			c = new_cmd(str);
-			list_add(cmd_list, (uintptr_t)c); // the list now owns cmd
+			history_add(str);
+			argc = cmd_tokenize(&curr_cmd, str);
+			has_cmd = argc > 0;
 			str_len = 0;
 			memset(str, 0, sizeof(str));
-			*cmd_out = c; // immutable borrow
 		}
 		wcli.current_pos_y++;
-		wcli.current_pos_x = strlen("> ")+1;;
+		wcli.current_pos_x = strlen("> ")+1;
+		if (argc == -1)
+			cli_printf("too many arguments (at most %d)", CLI_MAX_ARGS-2);
 	}
-	else if (ch == '\b') {
+	else if (ch == '\b' || ch == 127 || ch == KEY_BACKSPACE) {
 		if (str_len > 0) {
-			str[--str_len] = ' ';
+			str[--str_len] = '\0';
+			wcli.current_pos_x--;
+			mvwaddch(wcli.win, wcli.current_pos_y, wcli.current_pos_x, ' ');
 		}
 	}
+	else if (ch == KEY_UP || ch == KEY_DOWN) {
+		history_recall(ch == KEY_UP);
+	}
 	cli_redraw();
+
+	return has_cmd;
 }
 
-static uint16_t str_to_addr(const char *str) {
-	uint16_t addr = 0;
-	for (size_t i = 0; i < strlen(str); i++) {
-		if (str[i] >= '0' && str[i] <= '9') {
-			addr |= (str[i]-0x30) << ((strlen(str)-1-i) * 4);
-		}
-		else {
-			addr |= (str[i]-0x57) << ((strlen(str)-1-i) * 4);
-		}
+// hex, with an optional 0x prefix; "bank:addr" names an address in a given rom bank
+static uint32_t str_to_addr(const char *str) {
+	const char *colon = strchr(str, ':');
+	if (colon) {
+		uint32_t bank = strtoul(str, NULL, 16);
+		return ADDR_BANKED(bank, strtoul(colon+1, NULL, 16));
 	}
+	return strtoul(str, NULL, 16) & 0xffff;
+}
 
-	return addr;
+static void format_addr(char *buf, size_t size, uint32_t addr) {
+	if (ADDR_IS_BANKED(addr))
+		snprintf(buf, size, "%02x:%04x", ADDR_BANK(addr), ADDR_OFFSET(addr));
+	else
+		snprintf(buf, size, "%04x", addr);
 }
 
 static void handle_breakpoint(const struct cmd *cmd) {
-	uint16_t addr = 0;
-	char *str = cmd->argv[1];
-	if (str[0] == '0' && str[1] == 'x')
-		str += 2;
-
-	addr = str_to_addr(str);
-	client_set_breakpoint(addr);
+	uint32_t addr = str_to_addr(cmd->argv[1]);
+	if (cmd->argc > 2)
+		client_set_breakpoint_ignore(addr, strtoul(cmd->argv[2], NULL, 0));
+	else
+		client_set_breakpoint(addr);
 }
 
-static void handle_until(const struct cmd *cmd) {
-	uint16_t addr = 0;
-	char *str = cmd->argv[1];
-	if (str[0] == '0' && str[1] == 'x')
-		str += 2;
+static void handle_tracepoint(const struct cmd *cmd) {
+	client_set_tracepoint(str_to_addr(cmd->argv[1]));
+}
 
-	addr = str_to_addr(str);
-	client_control_flow_until(addr);
+static void handle_tplog(const struct cmd *cmd) {
+	if (cmd->argc > 1) {
+		if (strcmp(cmd->argv[1], "clear")) {
+			cli_printf("tplog: unknown subcommand '%s'", cmd->argv[1]);
+			return;
+		}
+		tplog_clear();
+	}
+	tplog_show();
+	cli_printf("tplog: %zu records", tplog_get_count());
 }
 
-static void handle_delete(const struct cmd *cmd) {
-	uint16_t addr = 0;
-	char *str = cmd->argv[1];
-	if (str) {
-		if (str[0] == '0' && str[1] == 'x')
-			str += 2;
-		addr = str_to_addr(str);
+#define MAX_BREAKPOINTS 256
+
+static void handle_hits(const struct cmd *cmd) {
+	static struct client_breakpoint_hits hits[MAX_BREAKPOINTS];
+	int num = client_get_breakpoint_hits(hits, MAX_BREAKPOINTS);
+	if (num == -1) {
+		cli_printf("hits: could not read breakpoints");
+		return;
 	}
 
+	results_clear("breakpoint hits");
+	for (int i = 0; i < num && i < MAX_BREAKPOINTS; i++) {
+		char addr[16];
+		format_addr(addr, sizeof(addr), hits[i].addr);
+		results_add(hits[i].addr, "%7s  %-5s %8u hits  %u to ignore", addr,
+				hits[i].is_tracepoint ? "trace" : "break", hits[i].hits, hits[i].ignore);
+	}
+	results_show();
+	cli_printf("hits: %d breakpoints", num);
+}
+
+static void handle_until(const struct cmd *cmd) {
+	client_control_flow_until(str_to_addr(cmd->argv[1]));
+}
+
+static void handle_delete(const struct cmd *cmd) {
+	uint32_t addr = cmd->argv[1] ? str_to_addr(cmd->argv[1]) : 0;
 	client_unset_breakpoint(addr);
 }
 
@@ -181,44 +263,567 @@ static void handle_continue(const struct cmd *cmd) {
 	client_control_flow_continue();
 }
 
-static bool parse_cmd(const struct cmd *command) {
-	if (!strcmp(command->argv[0], "break") || !strcmp(command->argv[0], "b")) {
-		handle_breakpoint(command);
+#define LINES_PER_FRAME 154
+
+static void handle_frame(const struct cmd *cmd) {
+	uint32_t num_frames = cmd->argc > 1 ? strtoul(cmd->argv[1], NULL, 0) : 1;
+	if (!num_frames) {
+		cli_printf("frame: need at least one frame");
+		return;
 	}
-	else if (!strcmp(command->argv[0], "until")) {
-		handle_until(command);
+	client_control_flow_frame(num_frames);
+}
+
+static void handle_vblank(const struct cmd *cmd) {
+	client_control_flow_vblank();
+}
+
+static void handle_line(const struct cmd *cmd) {
+	uint32_t ly = strtoul(cmd->argv[1], NULL, 0);
+	if (ly >= LINES_PER_FRAME) {
+		cli_printf("line: ly goes from 0 to %d", LINES_PER_FRAME-1);
+		return;
 	}
-	else if (!strcmp(command->argv[0], "c") || !strcmp(command->argv[0], "cont") ||
-			!strcmp(command->argv[0], "continue")) {
-		handle_continue(command);
+	client_control_flow_line(ly);
+}
+
+static void handle_over(const struct cmd *cmd) {
+	tui_step_over();
+}
+
+static void handle_finish(const struct cmd *cmd) {
+	tui_finish();
+}
+
+static uint32_t search_hits[RESULTS_MAX];
+
+static void handle_find(const struct cmd *cmd) {
+	int argi = 1;
+	bool rom = argi < cmd->argc && !strcmp(cmd->argv[argi], "rom");
+	if (rom)
+		argi++;
+	bool instr = argi < cmd->argc && !strcmp(cmd->argv[argi], "instr");
+	if (instr)
+		argi++;
+	if (argi >= cmd->argc) {
+		cli_printf("usage: find [rom] <byte>... | find [rom] instr <pattern> (?\? matches any byte)");
+		return;
 	}
-	else if (!strcmp(command->argv[0], "delete") || !strcmp(command->argv[0], "d")) {
-		handle_delete(command);
+
+	struct search_pattern pat;
+	char instr_pat[CLI_MAX_INPUT_SIZE] = {};
+	if (instr) {
+		for (int i = argi; i < cmd->argc; i++) {
+			if (i > argi)
+				strcat(instr_pat, " ");
+			strcat(instr_pat, cmd->argv[i]);
+		}
+	}
+	else if (search_parse_bytes(&pat, cmd->argc-argi, &cmd->argv[argi]) == -1) {
+		cli_printf("find: invalid byte pattern");
+		return;
+	}
+
+	// search over one bulk copy of the memory instead of querying address by address
+	uint32_t num_banks = rom ? client_get_rom_banks() : 0;
+	size_t size = rom ? num_banks * ROM_BANK_SIZE : 0x10000;
+	uint8_t *mem = malloc(size);
+	if (!mem) {
+		perror("malloc()");
+		return;
+	}
+	int ret = 0;
+	if (rom) {
+		for (uint32_t bank = 0; bank < num_banks && ret != -1; bank++)
+			ret = client_read_rom_bank(bank, &mem[bank * ROM_BANK_SIZE]);
 	}
 	else {
+		ret = client_read_mem(0, size, mem);
+	}
+	if (ret == -1) {
+		cli_printf("find: could not read memory");
+		goto out;
+	}
+
+	size_t num_hits = instr ?
+		search_instrs(mem, size, instr_pat, search_hits, RESULTS_MAX) :
+		search_bytes(mem, size, &pat, search_hits, RESULTS_MAX);
+
+	results_clear("find");
+	for (size_t i = 0; i < num_hits && i < RESULTS_MAX; i++) {
+		uint32_t offset = search_hits[i];
+		char text[RESULTS_TEXT_SIZE] = {};
+		if (instr) {
+			disasm_bytes(&mem[offset], text, sizeof(text));
+		}
+		else {
+			for (size_t j = 0; j < pat.len && j < sizeof(text)/3; j++)
+				sprintf(&text[j*3], "%02x ", mem[offset+j]);
+		}
+
+		if (rom) {
+			uint32_t bank = offset / ROM_BANK_SIZE;
+			uint32_t addr = (bank ? ROM_BANK_SIZE : 0) + offset % ROM_BANK_SIZE;
+			// hits in the switchable area jump to their own bank, not to the mapped one
+			results_add(bank ? ADDR_BANKED(bank, addr) : addr, "%02x:%04x  %s", bank, addr, text);
+		}
+		else {
+			results_add(offset, "%04x  %s", offset, text);
+		}
+	}
+	results_show();
+	cli_printf("find: %zu hits", num_hits);
+out:
+	free(mem);
+}
+
+static void list_snapshot_candidates(size_t num_candidates) {
+	results_clear("candidates");
+	if (num_candidates <= RESULTS_MAX) {
+		for (uint32_t addr = snapshot_next_candidate(0); addr < SNAPSHOT_SIZE;
+				addr = snapshot_next_candidate(addr+1)) {
+			results_add(addr, "%04x  %02x -> %02x", addr, snapshot_get_prev(addr),
+					snapshot_get_curr(addr));
+		}
+		results_show();
+	}
+	cli_printf("%zu candidates", num_candidates);
+}
+
+static void handle_snap(const struct cmd *cmd) {
+	if (client_read_mem(0, SNAPSHOT_SIZE, snapshot_get_buffer()) == -1) {
+		cli_printf("snap: could not read memory");
+		return;
+	}
+	size_t num_candidates = snapshot_reset();
+	cli_printf("snap: %zu candidates", num_candidates);
+}
+
+static void handle_diff(const struct cmd *cmd) {
+	static const struct {
+		const char *name;
+		enum snapshot_op op;
+	} ops[] = {
+		{ "changed", SNAPSHOT_CHANGED },
+		{ "unchanged", SNAPSHOT_UNCHANGED },
+		{ "inc", SNAPSHOT_INCREASED },
+		{ "dec", SNAPSHOT_DECREASED },
+		{ "eq", SNAPSHOT_EQUAL },
+	};
+
+	size_t i = 0;
+	if (cmd->argc > 1) {
+		for (; i < sizeof(ops)/sizeof(*ops); i++) {
+			if (!strcmp(cmd->argv[1], ops[i].name))
+				break;
+		}
+	}
+	if (cmd->argc < 2 || i == sizeof(ops)/sizeof(*ops) ||
+			(ops[i].op == SNAPSHOT_EQUAL && cmd->argc < 3)) {
+		cli_printf("usage: diff changed|unchanged|inc|dec|eq <value>");
+		return;
+	}
+	if (!snapshot_is_taken()) {
+		cli_printf("diff: take a snapshot first with snap");
+		return;
+	}
+
+	uint8_t value = 0;
+	if (ops[i].op == SNAPSHOT_EQUAL)
+		value = strtoul(cmd->argv[2], NULL, 0);
+
+	if (client_read_mem(0, SNAPSHOT_SIZE, snapshot_get_buffer()) == -1) {
+		cli_printf("diff: could not read memory");
+		return;
+	}
+	list_snapshot_candidates(snapshot_narrow(ops[i].op, value));
+}
+
+// reads the (up to 3) bytes of the instruction at `addr`, which may be banked
+static int read_instr_bytes(uint32_t addr, uint8_t *bytes) {
+	memset(bytes, 0, 3);
+	if (ADDR_IS_BANKED(addr)) {
+		struct instruction *instr = client_get_instruction(addr);
+		if (!instr)
+			return -1;
+		memcpy(bytes, instr->bytes, 3);
+		free(instr->str);
+		free(instr);
+		return 0;
+	}
+	uint32_t len = addr > 0xfffd ? 0x10000-addr : 3;
+	return client_read_mem(addr, len, bytes);
+}
+
+// every sample pauses the emulator for a round trip, and the period is waited out in ms
+#define PROFILE_MAX_RATE 1000
+
+static void handle_profile(const struct cmd *cmd) {
+	const char *sub = cmd->argc > 1 ? cmd->argv[1] : "top";
+
+	if (!strcmp(sub, "start")) {
+		uint32_t rate = cmd->argc > 2 ? strtoul(cmd->argv[2], NULL, 0) : PROFILE_DEFAULT_RATE;
+		if (rate > PROFILE_MAX_RATE)
+			rate = PROFILE_MAX_RATE;
+		profile_clear();
+		profile_start(rate);
+		cli_printf("profile: sampling at %u Hz, ctrl+c to stop", profile_get_rate());
+		client_control_flow_continue();
+	}
+	else if (!strcmp(sub, "stop")) {
+		profile_stop();
+		cli_printf("profile: %llu samples", (unsigned long long)profile_get_total());
+	}
+	else if (!strcmp(sub, "clear")) {
+		profile_clear();
+		tui_src_refresh();
+	}
+	else if (!strcmp(sub, "top")) {
+		uint32_t top[PROFILE_MAX_TOP];
+		size_t n = cmd->argc > 2 ? strtoul(cmd->argv[2], NULL, 0) : 16;
+		n = profile_get_top(top, n);
+
+		results_clear("profile");
+		for (size_t i = 0; i < n; i++) {
+			uint8_t bytes[3] = {};
+			char text[RESULTS_TEXT_SIZE] = {};
+			if (read_instr_bytes(top[i], bytes) != -1)
+				disasm_bytes(bytes, text, sizeof(text));
+			char addr[16];
+			format_addr(addr, sizeof(addr), top[i]);
+			results_add(top[i], "%-7s %5.1f%% %7u  %s", addr, profile_get_percent(top[i]),
+					profile_get_count(top[i]), text);
+		}
+		results_show();
+		tui_src_refresh();
+		cli_printf("profile: %llu samples", (unsigned long long)profile_get_total());
+	}
+	else {
+		cli_printf("usage: profile start [rate] | stop | clear | top [n]");
+	}
+}
+
+static void handle_trace(const struct cmd *cmd) {
+	if (!strcmp(cmd->argv[1], "clear")) {
+		trace_clear();
+		cli_printf("trace: cleared");
+		return;
+	}
+
+	// record the executed instructions by single-stepping. each step is one state request,
+	// which brings both the pc and the bytes at it, and the step message itself
+	uint32_t num_steps = strtoul(cmd->argv[1], NULL, 0);
+	for (uint32_t i = 0; i < num_steps; i++) {
+		const struct client_state *state;
+		if (client_get_state(3) == -1 || !(state = client_get_last_state()) || !state->code_len)
+			break;
+		uint8_t bytes[3] = {};
+		memcpy(bytes, state->code, state->code_len < 3 ? state->code_len : 3);
+		uint32_t pc = state->regs[CPU_REG_PC];
+		trace_add(ADDR_IS_SWITCHABLE(pc) ? ADDR_BANKED(state->bank, pc) : pc, bytes);
+		client_control_flow_next();
+	}
+	tui_show_stop_state();
+	cli_printf("trace: %zu records", trace_get_count());
+}
+
+static void list_callgraph_node(int idx, int depth) {
+	const struct callgraph_node *node = callgraph_get_node(idx);
+	char addr[16], name[24];
+	format_addr(addr, sizeof(addr), node->addr);
+	snprintf(name, sizeof(name), node->is_interrupt ? "int %s" : "%s", addr);
+	results_add(node->addr, "%*s%s x%u  incl %llu  excl %llu", depth, "", name, node->calls,
+			(unsigned long long)node->incl_cycles, (unsigned long long)node->excl_cycles);
+
+	for (int child = node->first_child; child != -1; child = callgraph_get_node(child)->next_sibling)
+		list_callgraph_node(child, depth < 16 ? depth+1 : depth);
+}
+
+static void handle_calls(const struct cmd *cmd) {
+	const char *sub = cmd->argc > 1 ? cmd->argv[1] : "incl";
+
+	if (!callgraph_build()) {
+		cli_printf("calls: the trace is empty; record one with trace <n>");
+		return;
+	}
+
+	if (!strcmp(sub, "export")) {
+		if (cmd->argc < 3) {
+			cli_printf("usage: calls export <file>");
+			return;
+		}
+		FILE *f = fopen(cmd->argv[2], "w");
+		if (!f) {
+			cli_printf("calls: could not open %s", cmd->argv[2]);
+			return;
+		}
+		int ret = callgraph_export_folded(f);
+		if (fclose(f) || ret == -1)
+			cli_printf("calls: could not write %s", cmd->argv[2]);
+		else
+			cli_printf("calls: wrote %s", cmd->argv[2]);
+		return;
+	}
+	if (strcmp(sub, "incl") && strcmp(sub, "excl")) {
+		cli_printf("usage: calls [incl|excl] | calls export <file>");
+		return;
+	}
+
+	callgraph_sort(!strcmp(sub, "incl") ? CALLGRAPH_SORT_INCL : CALLGRAPH_SORT_EXCL);
+	results_clear("calls");
+	list_callgraph_node(0, 0);
+	results_show();
+	cli_printf("calls: %d routines", callgraph_get_num_nodes());
+}
+
+static void handle_cost(const struct cmd *cmd) {
+	uint32_t from = str_to_addr(cmd->argv[1]);
+	uint32_t to = str_to_addr(cmd->argv[2]);
+	char from_str[16];
+	format_addr(from_str, sizeof(from_str), from);
+
+	struct cfg_cost cost;
+	if (cfg_cost(from, to, &cost) == -1) {
+		cli_printf("cost: no code at %s", from_str);
+		return;
+	}
+	if (cost.best == CFG_COST_UNBOUNDED) {
+		cli_printf("cost: no path leaves %s-%04x", from_str, ADDR_OFFSET(to));
+		return;
+	}
+
+	char worst[32];
+	if (cost.worst == CFG_COST_UNBOUNDED)
+		snprintf(worst, sizeof(worst), "unbounded (loop)");
+	else
+		snprintf(worst, sizeof(worst), "%llu", (unsigned long long)cost.worst);
+	cli_printf("cost %s-%04x: best %llu, worst %s cycles over %u blocks, excluding callees",
+			from_str, ADDR_OFFSET(to), (unsigned long long)cost.best, worst, cost.num_blocks);
+}
+
+static void handle_xrefs(const struct cmd *cmd) {
+	static const char *kinds[] = {
+		[XREF_JUMP] = "jump",
+		[XREF_CALL] = "call",
+		[XREF_READ] = "read",
+		[XREF_WRITE] = "write",
+		[XREF_IMM] = "imm",
+	};
+	uint32_t addr = str_to_addr(cmd->argv[1]);
+	char addr_str[16];
+	format_addr(addr_str, sizeof(addr_str), addr);
+
+	size_t num_xrefs = 0;
+	results_clear("xrefs");
+	for (const struct cfg_xref *xref = cfg_first_xref(addr); xref; xref = cfg_next_xref(xref)) {
+		// a banked target in the switchable area is only reached from its own bank, or from
+		// code that is always mapped
+		if (ADDR_IS_BANKED(addr) && ADDR_IS_SWITCHABLE(addr) && xref->bank &&
+				xref->bank != CFG_BANK_RAM && xref->bank != ADDR_BANK(addr))
+			continue;
+		char text[RESULTS_TEXT_SIZE] = {};
+		const uint8_t *bytes = cfg_get_mem(cfg_xref_from(xref));
+		if (bytes)
+			disasm_bytes(bytes, text, sizeof(text));
+		if (xref->bank == CFG_BANK_RAM)
+			results_add(xref->from, "   %04x  %-5s  %s", xref->from, kinds[xref->kind], text);
+		else
+			results_add(ADDR_BANKED(xref->bank, xref->from), "%02x:%04x  %-5s  %s", xref->bank,
+					xref->from, kinds[xref->kind], text);
+		num_xrefs++;
+	}
+	results_show();
+	cli_printf("xrefs: %zu references to %s", num_xrefs, addr_str);
+}
+
+static void list_coverage() {
+	static struct coverage_stats stats[CFG_MAX_BANKS];
+	int num_banks = coverage_get_stats(stats, CFG_MAX_BANKS);
+	if (num_banks == -1)
+		return;
+
+	uint64_t executed = 0;
+	results_clear("coverage");
+	for (int i = 0; i < num_banks && i < CFG_MAX_BANKS; i++) {
+		executed += stats[i].executed;
+		if (stats[i].decoded) {
+			results_add(i ? ROM_BANK_SIZE : 0, "bank %02x %6u ran  %5.1f%% of %u decoded", i,
+					stats[i].executed, 100.0 * stats[i].decoded_executed / stats[i].decoded,
+					stats[i].decoded);
+		}
+		else {
+			results_add(i ? ROM_BANK_SIZE : 0, "bank %02x %6u ran", i, stats[i].executed);
+		}
+	}
+	results_show();
+	cli_printf("coverage: %lu addresses ran in %d banks", (unsigned long)executed, num_banks);
+}
+
+static void handle_coverage(const struct cmd *cmd) {
+	const char *sub = cmd->argc > 1 ? cmd->argv[1] : "show";
+
+	if (!strcmp(sub, "off")) {
+		coverage_disable();
+		tui_src_refresh();
+		return;
+	}
+
+	// the map is fetched again at every stop from now on
+	if (coverage_update() == -1) {
+		cli_printf("coverage: could not read the coverage map");
+		return;
+	}
+
+	if (!strcmp(sub, "export")) {
+		if (cmd->argc < 3) {
+			cli_printf("usage: coverage export <file>");
+			return;
+		}
+		FILE *f = fopen(cmd->argv[2], "w");
+		if (!f) {
+			cli_printf("coverage: could not open %s", cmd->argv[2]);
+			return;
+		}
+		int ret = coverage_export(f);
+		if (fclose(f) || ret == -1)
+			cli_printf("coverage: could not write %s", cmd->argv[2]);
+		else
+			cli_printf("coverage: wrote %s", cmd->argv[2]);
+	}
+	else if (!strcmp(sub, "show")) {
+		list_coverage();
+	}
+	else {
+		cli_printf("coverage: unknown subcommand '%s'", sub);
+	}
+	tui_src_refresh();
+}
+
+static void handle_vram(const struct cmd *cmd) {
+	static const char *views[] = {
+		[VRAM_VIEW_TILES] = "tiles",
+		[VRAM_VIEW_BG] = "bg",
+		[VRAM_VIEW_WIN] = "win",
+	};
+	const char *view = cmd->argc > 1 ? cmd->argv[1] : "tiles";
+
+	for (int i = 0; i < VRAM_NUM_VIEWS; i++) {
+		if (!strcmp(view, views[i])) {
+			vram_show(i);
+			return;
+		}
+	}
+	cli_printf("vram: unknown view '%s'", view);
+}
+
+static void handle_watch(const struct cmd *cmd) {
+	char text[CLI_MAX_INPUT_SIZE] = {};
+	for (int i = 1; i < cmd->argc; i++) {
+		if (i > 1)
+			strcat(text, " ");
+		strcat(text, cmd->argv[i]);
+	}
+	if (watch_get_count() == WATCH_MAX) {
+		cli_printf("watch: at most %d expressions", WATCH_MAX);
+		return;
+	}
+	if (watch_add(text) == -1) {
+		cli_printf("watch: invalid expression '%s'", text);
+		return;
+	}
+	tui_reg_refresh();
+}
+
+static void handle_unwatch(const struct cmd *cmd) {
+	if (!strcmp(cmd->argv[1], "all")) {
+		watch_clear();
+	}
+	else if (watch_remove(strtoul(cmd->argv[1], NULL, 0)) == -1) {
+		cli_printf("unwatch: no watch %s", cmd->argv[1]);
+		return;
+	}
+	tui_reg_refresh();
+}
+
+struct cli_command {
+	const char *name;
+	const char *aliases[3];
+	int min_args, max_args; // not counting the command name; -1 means no limit
+	void (*handler)(const struct cmd *cmd);
+	const char *usage;
+};
+
+static const struct cli_command commands[] = {
+	{ "break", { "b" }, 1, 2, handle_breakpoint, "break <addr> [ignore]" },
+	{ "tracepoint", { "tp" }, 1, 1, handle_tracepoint, "tracepoint <addr>" },
+	{ "tplog", {}, 0, 1, handle_tplog, "tplog [clear]" },
+	{ "hits", {}, 0, 0, handle_hits, "hits" },
+	{ "until", {}, 1, 1, handle_until, "until <addr>" },
+	{ "continue", { "c", "cont" }, 0, 0, handle_continue, "continue" },
+	{ "over", { "o" }, 0, 0, handle_over, "over" },
+	{ "frame", {}, 0, 1, handle_frame, "frame [N]" },
+	{ "vblank", {}, 0, 0, handle_vblank, "vblank" },
+	{ "line", {}, 1, 1, handle_line, "line <ly>" },
+	{ "finish", { "fin" }, 0, 0, handle_finish, "finish" },
+	{ "delete", { "d" }, 0, 1, handle_delete, "delete [addr]" },
+	{ "find", {}, 1, -1, handle_find, "find [rom] <byte>... | find [rom] instr <pattern>" },
+	{ "snap", {}, 0, 0, handle_snap, "snap" },
+	{ "diff", {}, 1, 2, handle_diff, "diff changed|unchanged|inc|dec|eq <value>" },
+	{ "profile", {}, 0, 2, handle_profile, "profile start [rate] | stop | clear | top [n]" },
+	{ "trace", {}, 1, 1, handle_trace, "trace <steps> | trace clear" },
+	{ "calls", {}, 0, 2, handle_calls, "calls [incl|excl] | calls export <file>" },
+	{ "cost", {}, 2, 2, handle_cost, "cost <from> <to>" },
+	{ "xrefs", { "x" }, 1, 1, handle_xrefs, "xrefs <addr>" },
+	{ "vram", {}, 0, 1, handle_vram, "vram [tiles|bg|win]" },
+	{ "coverage", { "cov" }, 0, 2, handle_coverage, "coverage [show|off|export <file>]" },
+	{ "watch", { "w" }, 1, -1, handle_watch, "watch <expr>, e.g. [0xc0a0], word [hl], a & 0x0f" },
+	{ "unwatch", {}, 1, 1, handle_unwatch, "unwatch <n>|all" },
+};
+
+static const struct cli_command *lookup_cmd(const char *name) {
+	for (size_t i = 0; i < sizeof(commands)/sizeof(*commands); i++) {
+		const struct cli_command *c = &commands[i];
+		if (!strcmp(c->name, name))
+			return c;
+		for (size_t j = 0; j < sizeof(c->aliases)/sizeof(*c->aliases) && c->aliases[j]; j++) {
+			if (!strcmp(c->aliases[j], name))
+				return c;
+		}
+	}
+	return NULL;
+}
+
+static bool parse_cmd(const struct cmd *command) {
+	const struct cli_command *c = lookup_cmd(command->argv[0]);
+	if (!c) {
+		cli_printf("unknown command: %s", command->argv[0]);
 		return false;
 	}
+
+	int num_args = command->argc-1;
+	if (num_args < c->min_args || (c->max_args != -1 && num_args > c->max_args)) {
+		cli_printf("usage: %s", c->usage);
+		return false;
+	}
+	c->handler(command);
+
 	return true;
 }
 
 void cli_window_handle_input(int ch) {
-	struct cmd *curr_cmd;
-
-	cli_parse(ch, &curr_cmd);
-	if (!curr_cmd) {
+	if (!cli_parse(ch)) {
 		return;
 	}
-	curr_cmd->valid = parse_cmd(curr_cmd);
+	parse_cmd(&curr_cmd);
 }
 
 WINDOW *cli_init() {
-	cmd_list = create_list();
-
 	wcli.win = newwin(LINES/3, COLS/2, LINES-(LINES/3), 0);
 	wcli.current_pos_y = 1;
 	wcli.current_pos_x = sizeof("> ");;
 	getmaxyx(wcli.win, wcli.max_y, wcli.max_x);
 	scrollok(wcli.win, TRUE);
+	keypad(wcli.win, TRUE);
 
 	return wcli.win;
 }
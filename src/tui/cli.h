@@ -34,14 +34,18 @@ struct cli_window {
 	list_t *instrs;
 };
 
+#define CLI_MAX_INPUT_SIZE 256
+#define CLI_MAX_ARGS 64
+
 struct cmd {
 	int argc;
-	char **argv;
-	bool valid;
+	char *argv[CLI_MAX_ARGS];
+	char buf[CLI_MAX_INPUT_SIZE]; // argv points into this buffer
 };
 
 WINDOW *cli_init();
 void cli_redraw();
 void cli_window_handle_input(int ch);
+void cli_printf(const char *fmt, ...);
 
 #endif
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "client.h"
+#include "ioregs.h"
+
+// the registers and IE are fetched with one batched read per stop and decoded locally; the
+// copy from the previous stop tells which registers changed. IE comes right after the others.
+static uint8_t regs[IOREGS_SIZE+1], prev_regs[IOREGS_SIZE+1];
+static bool has_prev, has_regs;
+
+struct io_field {
+	uint8_t reg; // offset into regs
+	const char *name;
+	void (*decode)(uint8_t val, char *buf, size_t size);
+};
+
+static void decode_lcdc(uint8_t val, char *buf, size_t size) {
+	snprintf(buf, size, "%s bg:%s win:%s obj:%s map:%s/%s tiles:%s",
+			val & 0x80 ? "on" : "off",
+			val & 0x01 ? "on" : "off",
+			val & 0x20 ? "on" : "off",
+			val & 0x02 ? (val & 0x04 ? "8x16" : "8x8") : "off",
+			val & 0x08 ? "9c00" : "9800",
+			val & 0x40 ? "9c00" : "9800",
+			val & 0x10 ? "8000" : "8800");
+}
+
+static void decode_stat(uint8_t val, char *buf, size_t size) {
+	static const char *modes[] = { "hblank", "vblank", "oam", "draw" };
+	snprintf(buf, size, "%s%s int:%s%s%s%s", modes[val & 3],
+			val & 0x04 ? " ly=lyc" : "",
+			val & 0x08 ? "h" : "-",
+			val & 0x10 ? "v" : "-",
+			val & 0x20 ? "o" : "-",
+			val & 0x40 ? "l" : "-");
+}
+
+static void decode_dec(uint8_t val, char *buf, size_t size) {
+	snprintf(buf, size, "(%u)", val);
+}
+
+// shade of colours 0 to 3
+static void decode_palette(uint8_t val, char *buf, size_t size) {
+	snprintf(buf, size, "%u%u%u%u", val & 3, val >> 2 & 3, val >> 4 & 3, val >> 6 & 3);
+}
+
+static void decode_ints(uint8_t val, char *buf, size_t size) {
+	snprintf(buf, size, "%s%s%s%s%s",
+			val & 0x01 ? "vblank " : "",
+			val & 0x02 ? "stat " : "",
+			val & 0x04 ? "timer " : "",
+			val & 0x08 ? "serial " : "",
+			val & 0x10 ? "joyp" : "");
+}
+
+static void decode_tac(uint8_t val, char *buf, size_t size) {
+	static const char *freqs[] = { "4096Hz", "262kHz", "65kHz", "16kHz" };
+	snprintf(buf, size, "%s %s", val & 0x04 ? "on" : "off", freqs[val & 3]);
+}
+
+static void decode_nr52(uint8_t val, char *buf, size_t size) {
+	snprintf(buf, size, "%s ch:%c%c%c%c", val & 0x80 ? "on" : "off",
+			val & 0x01 ? '1' : '-',
+			val & 0x02 ? '2' : '-',
+			val & 0x04 ? '3' : '-',
+			val & 0x08 ? '4' : '-');
+}
+
+#define IO_MAX_FIELDS 4
+
+static const struct io_field rows[][IO_MAX_FIELDS] = {
+	{ { 0x40, "LCDC", decode_lcdc } },
+	{ { 0x41, "STAT", decode_stat } },
+	{ { 0x44, "LY", decode_dec }, { 0x45, "LYC", decode_dec } },
+	{ { 0x42, "SCY", NULL }, { 0x43, "SCX", NULL },
+		{ 0x4a, "WY", NULL }, { 0x4b, "WX", NULL } },
+	{ { 0x47, "BGP", decode_palette }, { 0x48, "OBP0", decode_palette },
+		{ 0x49, "OBP1", decode_palette } },
+	{ { 0x0f, "IF", decode_ints } },
+	{ { IOREGS_SIZE, "IE", decode_ints } },
+	{ { 0x04, "DIV", NULL }, { 0x05, "TIMA", NULL }, { 0x06, "TMA", NULL },
+		{ 0x07, "TAC", decode_tac } },
+	{ { 0x26, "NR52", decode_nr52 }, { 0x24, "NR50", NULL }, { 0x25, "NR51", NULL } },
+	{ { 0x00, "JOYP", NULL }, { 0x01, "SB", NULL }, { 0x02, "SC", NULL },
+		{ 0x46, "DMA", NULL } },
+};
+
+// `stopped` if the cpu ran since the last update; otherwise the registers are only read again
+// and the changes shown are still those of the last stop
+int ioregs_update(bool stopped) {
+	static const struct client_mem_range ranges[] = {
+		{ IOREGS_BASE, IOREGS_SIZE },
+		{ IOREGS_IE, 1 },
+	};
+	if (stopped && has_regs) {
+		memcpy(prev_regs, regs, sizeof(regs));
+		has_prev = true;
+	}
+	if (client_read_mem_batch(ranges, sizeof(ranges)/sizeof(*ranges), regs) == -1) {
+		has_regs = has_prev = false;
+		return -1;
+	}
+	has_regs = true;
+	return 0;
+}
+
+// value of a register as of the last stop, or -1 if it could not be read
+int ioregs_get(uint32_t addr) {
+	if (!has_regs)
+		return -1;
+	if (addr == IOREGS_IE)
+		return regs[IOREGS_SIZE];
+	if (addr < IOREGS_BASE || addr >= IOREGS_BASE + IOREGS_SIZE)
+		return -1;
+	return regs[addr - IOREGS_BASE];
+}
+
+// returns the row after the panel
+int ioregs_draw(WINDOW *win, int y) {
+	int max_y, max_x;
+	getmaxyx(win, max_y, max_x);
+
+	for (size_t i = 0; i < sizeof(rows)/sizeof(*rows) && y < max_y-1; i++, y++) {
+		wmove(win, y, 1);
+		wclrtoeol(win);
+		if (!has_regs)
+			continue;
+
+		int x = 1;
+		for (size_t j = 0; j < IO_MAX_FIELDS && rows[i][j].name && x < max_x-1; j++) {
+			const struct io_field *f = &rows[i][j];
+			uint8_t val = regs[f->reg];
+			char text[64], decoded[48] = {};
+			if (f->decode)
+				f->decode(val, decoded, sizeof(decoded));
+			int len = snprintf(text, sizeof(text), "%s:%02x%s%s", f->name, val,
+					f->decode ? " " : "", decoded);
+
+			bool changed = has_prev && prev_regs[f->reg] != val;
+			if (changed)
+				wattron(win, A_REVERSE);
+			mvwaddnstr(win, y, x, text, max_x-1-x);
+			if (changed)
+				wattroff(win, A_REVERSE);
+			x += len + 2;
+		}
+	}
+	return y;
+}
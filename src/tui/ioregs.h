@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef IOREGS_H
+#define IOREGS_H
+
+#include <ncurses.h>
+
+// the I/O registers, plus IE which sits past hram at the very end of the page
+#define IOREGS_BASE 0xff00
+#define IOREGS_SIZE 0x80
+#define IOREGS_IE 0xffff
+
+int ioregs_update(bool stopped);
+int ioregs_draw(WINDOW *win, int y);
+int ioregs_get(uint32_t addr);
+
+#endif
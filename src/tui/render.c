@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#include <time.h>
+
+#include "render.h"
+
+// windows that changed are copied to curses' virtual screen as they are marked, in the same
+// order a wrefresh() would have drawn them, and the terminal is brought up to date with a
+// single doupdate() per input event. curses then sends only the cells that differ from what
+// is already on the terminal, in one write.
+static bool pending;
+static struct timespec last_update;
+
+void render_mark(WINDOW *win) {
+	wnoutrefresh(win);
+	pending = true;
+}
+
+void render_mark_pad(WINDOW *pad, int top, int left, int min_y, int min_x, int max_y, int max_x) {
+	pnoutrefresh(pad, top, left, min_y, min_x, max_y, max_x);
+	pending = true;
+}
+
+bool render_is_pending() {
+	return pending;
+}
+
+// `cursor_win`, if any, gets the cursor. it's copied last, which draws nothing unless it
+// changed since it was marked; it is also the window input is read from, which curses would
+// otherwise refresh on its own.
+void render_flush(WINDOW *cursor_win) {
+	if (cursor_win && is_wintouched(cursor_win))
+		pending = true;
+	if (!pending)
+		return;
+	if (cursor_win)
+		wnoutrefresh(cursor_win);
+	doupdate();
+	pending = false;
+	clock_gettime(CLOCK_MONOTONIC, &last_update);
+}
+
+// for updates that keep coming while the emulator runs; what's skipped goes out with a
+// later flush
+void render_flush_capped(WINDOW *cursor_win) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	long elapsed_ns = (now.tv_sec - last_update.tv_sec) * 1000000000L +
+		now.tv_nsec - last_update.tv_nsec;
+	if (elapsed_ns >= 1000000000L / RENDER_MAX_FPS)
+		render_flush(cursor_win);
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+
+// the terminal is updated at most this often while the emulator runs
+#define RENDER_MAX_FPS 30
+
+void render_mark(WINDOW *win);
+void render_mark_pad(WINDOW *pad, int top, int left, int min_y, int min_x, int max_y, int max_x);
+bool render_is_pending();
+void render_flush(WINDOW *cursor_win);
+void render_flush_capped(WINDOW *cursor_win);
+
+#endif
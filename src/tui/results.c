@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "render.h"
+#include "results.h"
+#include "tui.h"
+
+// the results pane lists addresses produced by commands (search hits, etc.) and lets the user
+// jump to any of them in the source window. it is drawn over the help window while visible.
+struct results_window {
+	WINDOW *win;
+	int max_y, max_x;
+	char title[RESULTS_TEXT_SIZE];
+
+	struct result results[RESULTS_MAX];
+	size_t num_results;
+	size_t selected;
+	size_t top;
+	bool visible;
+};
+static struct results_window wres;
+
+void results_clear(const char *title) {
+	snprintf(wres.title, sizeof(wres.title), "%s", title);
+	wres.num_results = 0;
+	wres.selected = 0;
+	wres.top = 0;
+}
+
+void results_add(uint32_t addr, const char *fmt, ...) {
+	if (wres.num_results == RESULTS_MAX)
+		return;
+
+	struct result *res = &wres.results[wres.num_results++];
+	res->addr = addr;
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(res->text, sizeof(res->text), fmt, ap);
+	va_end(ap);
+}
+
+void results_redraw(bool focused) {
+	if (!wres.visible)
+		return;
+
+	int num_rows = wres.max_y-2;
+	if (wres.selected < wres.top)
+		wres.top = wres.selected;
+	else if (wres.selected >= wres.top + num_rows)
+		wres.top = wres.selected - num_rows + 1;
+
+	werase(wres.win);
+	if (focused)
+		wborder(wres.win, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
+	else
+		wborder(wres.win, 0, 0, 0, 0, 0, 0, 0, 0);
+	mvwprintw(wres.win, 0, 2, " %s: %zu ", wres.title, wres.num_results);
+
+	for (int i = 0; i < num_rows && wres.top + i < wres.num_results; i++) {
+		size_t idx = wres.top + i;
+		if (idx == wres.selected)
+			wattron(wres.win, A_REVERSE);
+		mvwaddnstr(wres.win, i+1, 1, wres.results[idx].text, wres.max_x-2);
+		wattroff(wres.win, A_REVERSE);
+	}
+	render_mark(wres.win);
+}
+
+void results_handle_input(int ch) {
+	if (!wres.num_results && ch != 'q')
+		return;
+
+	switch (ch) {
+		case 'j':
+			if (wres.selected+1 < wres.num_results)
+				wres.selected++;
+			break;
+		case 'k':
+			if (wres.selected > 0)
+				wres.selected--;
+			break;
+		case KEY_NPAGE:
+			wres.selected += wres.max_y-2;
+			if (wres.selected >= wres.num_results)
+				wres.selected = wres.num_results-1;
+			break;
+		case KEY_PPAGE:
+			wres.selected = wres.selected > (size_t)wres.max_y-2 ? wres.selected-(wres.max_y-2) : 0;
+			break;
+		case '\n':
+			tui_src_goto(wres.results[wres.selected].addr);
+			break;
+		case 'q':
+			results_hide();
+			return;
+	}
+	results_redraw(true);
+}
+
+void results_show() {
+	wres.visible = true;
+	results_redraw(false);
+}
+
+void results_hide() {
+	wres.visible = false;
+}
+
+bool results_is_visible() {
+	return wres.visible;
+}
+
+const char *results_get_title() {
+	return wres.title;
+}
+
+WINDOW *results_init(WINDOW *win) {
+	if (!win)
+		return NULL;
+
+	wres.win = win;
+	getmaxyx(wres.win, wres.max_y, wres.max_x);
+	keypad(wres.win, true);
+
+	return wres.win;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <ncurses.h>
+
+#define RESULTS_MAX 1024
+#define RESULTS_TEXT_SIZE 64
+
+struct result {
+	uint32_t addr;
+	char text[RESULTS_TEXT_SIZE];
+};
+
+WINDOW *results_init(WINDOW *win);
+void results_clear(const char *title);
+void results_add(uint32_t addr, const char *fmt, ...);
+void results_show();
+void results_hide();
+bool results_is_visible();
+const char *results_get_title();
+void results_redraw(bool focused);
+void results_handle_input(int ch);
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "client.h"
+#include "disasm.h"
+#include "stack.h"
+
+// bytes shown below sp, i.e. the last words popped
+#define STACK_BELOW 4
+
+// the span is read in one go and kept across stops. after a run it is read again; after a
+// single step only the bytes between the old and new sp can have changed (push, call, rst),
+// unless the instruction stored through a pointer.
+static struct {
+	uint8_t mem[STACK_SPAN];
+	uint32_t base;
+	uint32_t sp;
+	bool valid;
+	bool stepped;
+	bool step_stores;
+} stack;
+
+static bool stores_through_pointer(const uint8_t *bytes) {
+	uint8_t op = bytes[0];
+	if (op == 0xcb)
+		return (bytes[1] & 7) == 6 && (bytes[1] < 0x40 || bytes[1] >= 0x80); // all but bit
+	switch (op) {
+		case 0x02: case 0x12: case 0x22: case 0x32: // ld (bc)/(de)/(hl+)/(hl-), a
+		case 0x34: case 0x35: case 0x36: // inc/dec/ld (hl)
+		case 0x08: // ld (a16), sp
+		case 0xe0: case 0xe2: case 0xea: // ldh (a8)/(c), ld (a16)
+			return true;
+	}
+	return op >= 0x70 && op <= 0x77 && op != 0x76; // ld (hl), r
+}
+
+void stack_invalidate() {
+	stack.valid = false;
+}
+
+// called with the instruction about to be single-stepped
+void stack_note_step(const uint8_t *bytes) {
+	stack.stepped = true;
+	stack.step_stores = stores_through_pointer(bytes);
+}
+
+static int read_span(uint32_t from, uint32_t to) {
+	if (from >= to)
+		return 0;
+	return client_read_mem(from, to - from, &stack.mem[from - stack.base]);
+}
+
+int stack_update(uint32_t sp) {
+	sp &= 0xffff;
+	bool stepped = stack.stepped;
+	stack.stepped = false;
+
+	// near the top of memory there is nothing more to keep above sp
+	bool in_span = stack.valid && sp >= stack.base + STACK_BELOW &&
+		(sp + STACK_SPAN/2 <= stack.base + STACK_SPAN || stack.base + STACK_SPAN == 0x10000);
+	if (!in_span) {
+		// recentre so that most of the span lies above sp, where the frames are
+		stack.base = sp > STACK_BELOW ? sp - STACK_BELOW : 0;
+		if (stack.base + STACK_SPAN > 0x10000)
+			stack.base = 0x10000 - STACK_SPAN;
+		stack.valid = false;
+	}
+
+	int ret;
+	if (!stack.valid || !stepped || stack.step_stores) {
+		ret = read_span(stack.base, stack.base + STACK_SPAN);
+	}
+	else {
+		uint32_t from = sp < stack.sp ? sp : stack.sp, to = sp < stack.sp ? stack.sp : sp;
+		ret = read_span(from, to);
+	}
+	stack.valid = ret != -1;
+	stack.sp = sp;
+	return ret;
+}
+
+// the word is a likely return address if it follows a call or a rst. only rom is looked at:
+// code is rarely run from ram, and every other word on the stack would make the graph read
+// the whole ram region. words in the switchable area are decoded against the mapped bank,
+// which need not be the one the call was made from.
+static const uint8_t *find_call_site(uint32_t word, uint32_t *site) {
+	uint32_t target;
+	const uint8_t *bytes;
+	if (word >= 2*ROM_BANK_SIZE)
+		return NULL;
+	if (word >= 3 && (bytes = cfg_get_mem(word - 3))) {
+		enum disasm_flow flow = disasm_op_flow(bytes, word - 3, &target);
+		if (flow == FLOW_CALL || flow == FLOW_CALL_COND) {
+			*site = word - 3;
+			return bytes;
+		}
+	}
+	if (word >= 1 && (bytes = cfg_get_mem(word - 1)) &&
+			disasm_op_flow(bytes, word - 1, &target) == FLOW_RST) {
+		*site = word - 1;
+		return bytes;
+	}
+	return NULL;
+}
+
+// returns the row after the pane
+int stack_draw(WINDOW *win, int y) {
+	int max_y, max_x;
+	getmaxyx(win, max_y, max_x);
+
+	uint32_t addr = stack.sp >= stack.base + STACK_BELOW ? stack.sp - STACK_BELOW : stack.base;
+	for (; y < max_y-1; y++, addr += 2) {
+		wmove(win, y, 1);
+		wclrtoeol(win);
+		if (!stack.valid || addr + 2 > stack.base + STACK_SPAN)
+			continue;
+
+		uint32_t word = stack.mem[addr - stack.base] | stack.mem[addr - stack.base + 1] << 8;
+		char line[96], text[32] = {};
+		uint32_t site;
+		const uint8_t *bytes = addr >= stack.sp ? find_call_site(word, &site) : NULL;
+		if (bytes) {
+			disasm_bytes(bytes, text, sizeof(text));
+			// say which bank the call site was taken from
+			char site_str[16];
+			if (ADDR_IS_SWITCHABLE(site))
+				snprintf(site_str, sizeof(site_str), "%02x:%04x", client_get_mapped_bank(), site);
+			else
+				snprintf(site_str, sizeof(site_str), "%04x", site);
+			snprintf(line, sizeof(line), "%c%04x: %04x  <- %s %s", addr == stack.sp ? '>' : ' ',
+					addr, word, site_str, text);
+		}
+		else {
+			snprintf(line, sizeof(line), "%c%04x: %04x", addr == stack.sp ? '>' : ' ', addr, word);
+		}
+
+		// popped words are only context
+		if (addr < stack.sp)
+			wattron(win, A_DIM);
+		mvwaddnstr(win, y, 1, line, max_x-2);
+		wattroff(win, A_DIM);
+	}
+	return y;
+}
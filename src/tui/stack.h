@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef STACK_H
+#define STACK_H
+
+#include <ncurses.h>
+#include <stdint.h>
+
+// bytes of the stack kept around sp
+#define STACK_SPAN 128
+
+int stack_update(uint32_t sp);
+void stack_invalidate();
+void stack_note_step(const uint8_t *bytes);
+int stack_draw(WINDOW *win, int y);
+
+#endif
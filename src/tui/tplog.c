@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include "results.h"
+#include "tplog.h"
+
+#define TPLOG_TITLE "tracepoints"
+
+// tracepoint records arrive in batches from the server and are kept in a ring, oldest
+// first; the log is shown in the results pane and follows new batches while it's open.
+static struct client_tracepoint_record records[TPLOG_MAX];
+static size_t head, count;
+
+static bool is_shown() {
+	return results_is_visible() && !strcmp(results_get_title(), TPLOG_TITLE);
+}
+
+void tplog_add(const struct client_tracepoint_record *recs, size_t num) {
+	for (size_t i = 0; i < num; i++) {
+		records[(head + count) % TPLOG_MAX] = recs[i];
+		if (count < TPLOG_MAX)
+			count++;
+		else
+			head = (head+1) % TPLOG_MAX;
+	}
+
+	// one redraw per batch
+	if (num && is_shown())
+		tplog_show();
+}
+
+void tplog_clear() {
+	head = count = 0;
+}
+
+size_t tplog_get_count() {
+	return count;
+}
+
+// the pane holds fewer entries than the ring, so it shows the newest ones
+void tplog_show() {
+	results_clear(TPLOG_TITLE);
+	size_t first = count > RESULTS_MAX ? count - RESULTS_MAX : 0;
+	for (size_t i = first; i < count; i++) {
+		const struct client_tracepoint_record *rec = &records[(head + i) % TPLOG_MAX];
+		results_add(rec->addr, "%04x f:%-6u af:%04x bc:%04x de:%04x hl:%04x sp:%04x",
+				rec->addr & 0xffff, rec->frame, rec->af, rec->bc, rec->de, rec->hl, rec->sp);
+	}
+	results_show();
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef TPLOG_H
+#define TPLOG_H
+
+#include <stddef.h>
+
+#include "client.h"
+
+#define TPLOG_MAX 4096
+
+void tplog_add(const struct client_tracepoint_record *recs, size_t num);
+void tplog_clear();
+size_t tplog_get_count();
+void tplog_show();
+
+#endif
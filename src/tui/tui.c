@@ -16,18 +16,37 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
+#include <errno.h>
+#include <locale.h>
+#include <poll.h>
 #include <signal.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
 
 #include <ncurses.h>
 #include <libemu.h>
 
 #include "cli.h"
 #include "client.h"
-
+#include "ioregs.h"
+#include "render.h"
+#include "results.h"
+#include "stack.h"
+#include "tplog.h"
+#include "tui.h"
+#include "vram.h"
+#include "watch.h"
+
+#include "cfg.h"
+#include "cfgcache.h"
+#include "coverage.h"
 #include "disasm.h"
+#include "profile.h"
 
 struct wsrc_instr {
 	struct instruction *instr;
@@ -44,6 +63,12 @@ struct source_window {
 	struct instruction current_highlight;
 	struct wsrc_instr current_instr;
 	list_t *instrs;
+	uint32_t bank; // rom bank on display in 0x4000-0x7fff
+	bool scrolled_up; // direction of the last scroll, to read ahead the right way
+
+	// where we followed branches from, to come back
+	uint32_t jump_history[16];
+	size_t num_jumps;
 };
 
 typedef struct {
@@ -53,6 +78,8 @@ typedef struct {
 	WINDOW *focus_window;
 	WINDOW *help_window;
 	WINDOW *misc_window;
+	WINDOW *results_window;
+	WINDOW *vram_window;
 } tui_t;
 tui_t tui;
 
@@ -83,38 +110,85 @@ static char *handle_get_instr_at_addr(uint32_t *instr, uint32_t size) {
 	return disasm(instr, size);
 }
 
+#define STATUS_RATE 10
+
+// shown under the "emulator is executing" message
+static void handle_monitor_status(const struct client_status *status) {
+	if (!client_is_server_executing())
+		return;
+
+	char line[128];
+	snprintf(line, sizeof(line), "pc:%04x ly:%3u frame:%u %.2f MIPS %.1f ms",
+			status->pc & 0xffff, status->ly, status->frame,
+			status->instrs_per_sec / 1e6, status->frame_time_us / 1e3);
+
+	int max_x, max_y;
+	getmaxyx(tui.misc_window, max_y, max_x);
+	wmove(tui.misc_window, max_y/2+1, 1);
+	wclrtoeol(tui.misc_window);
+	mvwaddnstr(tui.misc_window, max_y/2+1, 2, line, max_x-4);
+	wborder(tui.misc_window, 0, 0, 0, 0, 0, 0, 0, 0);
+	render_mark(tui.misc_window);
+}
+
+static void handle_bank_switch(uint32_t bank) {
+	// code decoded from the other banks stays cached
+	cfg_set_bank(bank);
+}
+
+static void handle_tracepoint_records(const struct client_tracepoint_record *recs, size_t num) {
+	tplog_add(recs, num);
+}
+
 struct dispatch_table disp = {
 	.handle_control_flow_break = handle_control_flow_break,
 	.handle_control_flow_until = handle_control_flow_until,
 	.handle_get_instr_at_addr = handle_get_instr_at_addr,
+	.handle_monitor_status = handle_monitor_status,
+	.handle_tracepoint_records = handle_tracepoint_records,
+	.handle_bank_switch = handle_bank_switch,
 };
 
 static void change_focus() {
 	if (tui.focus_window == tui.src_window.win) {
 		wborder(tui.focus_window, 0, 0, 0, 0, 0, 0, 0, 0);
-		wrefresh(tui.focus_window);
+		render_mark(tui.focus_window);
 		tui.focus_window = tui.cli_window;
 		wborder(tui.focus_window, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
-		wrefresh(tui.focus_window);
+		render_mark(tui.focus_window);
 		cli_redraw();
 		curs_set(1);
 		echo();
 	}
 	else if (tui.focus_window == tui.cli_window) {
 		wborder(tui.focus_window, 0, 0, 0, 0, 0, 0, 0, 0);
-		wrefresh(tui.focus_window);
+		render_mark(tui.focus_window);
 		tui.focus_window = tui.reg_window;
 		wborder(tui.focus_window, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
-		wrefresh(tui.focus_window);
+		render_mark(tui.focus_window);
 		curs_set(0);
 		noecho();
 	}
+	else if (tui.focus_window == tui.reg_window && results_is_visible()) {
+		wborder(tui.focus_window, 0, 0, 0, 0, 0, 0, 0, 0);
+		render_mark(tui.focus_window);
+		tui.focus_window = tui.results_window;
+		results_redraw(true);
+	}
+	else if ((tui.focus_window == tui.reg_window || tui.focus_window == tui.results_window) &&
+			vram_is_visible()) {
+		wborder(tui.focus_window, 0, 0, 0, 0, 0, 0, 0, 0);
+		render_mark(tui.focus_window);
+		results_redraw(false);
+		tui.focus_window = tui.vram_window;
+		vram_redraw(true);
+	}
 	else {
 		wborder(tui.focus_window, 0, 0, 0, 0, 0, 0, 0, 0);
-		wrefresh(tui.focus_window);
+		render_mark(tui.focus_window);
 		tui.focus_window = tui.src_window.win;
 		wborder(tui.focus_window, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
-		wrefresh(tui.focus_window);
+		render_mark(tui.focus_window);
 	}
 }
 
@@ -123,79 +197,227 @@ static inline void refresh_all() {
 	touchwin(tui.cli_window);
 	touchwin(tui.src_window.win);
 	touchwin(tui.help_window);
-	wrefresh(tui.reg_window);
-	wrefresh(tui.cli_window);
-	wrefresh(tui.src_window.win);
-	wrefresh(tui.help_window);
+	render_mark(tui.reg_window);
+	render_mark(tui.cli_window);
+	render_mark(tui.src_window.win);
+	render_mark(tui.help_window);
+	results_redraw(tui.focus_window == tui.results_window);
+	vram_redraw(tui.focus_window == tui.vram_window);
+}
+
+// signals are read from a signalfd by the main loop instead of being handled asynchronously,
+// so a ctrl+c never lands in the middle of a message to the emulator or of a screen update
+static int sig_fd = -1;
+
+static int signals_init() {
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGWINCH);
+	if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
+		perror("sigprocmask()");
+		return -1;
+	}
+	if ((sig_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC)) == -1) {
+		perror("signalfd()");
+		return -1;
+	}
+	return 0;
 }
 
-static void sigint_handler(int _) {
+static void tui_quit() {
+	endwin();
+	if (cfgcache_is_dirty())
+		cfgcache_save();
+	exit(0);
+}
+
+// a first ctrl+c shows a prompt for EXIT_PROMPT_MS; a second one while it's up exits
+#define EXIT_PROMPT_MS 3000
+static bool exit_prompt_shown;
+static struct timespec exit_prompt_deadline;
+
+static void show_exit_prompt() {
+	const char *exit_monitor_str = "send ctrl+c again to exit monitor";
+	wborder(tui.misc_window, 0, 0, 0, 0, 0, 0, 0, 0);
+	int max_x, max_y;
+	getmaxyx(tui.misc_window, max_y, max_x);
+	mvwaddstr(tui.misc_window, max_y/2, max_x/2 - strlen(exit_monitor_str)/2, exit_monitor_str);
+	render_mark(tui.misc_window);
+
+	clock_gettime(CLOCK_MONOTONIC, &exit_prompt_deadline);
+	exit_prompt_deadline.tv_sec += EXIT_PROMPT_MS / 1000;
+	exit_prompt_deadline.tv_nsec += (EXIT_PROMPT_MS % 1000) * 1000000L;
+	if (exit_prompt_deadline.tv_nsec >= 1000000000L) {
+		exit_prompt_deadline.tv_sec++;
+		exit_prompt_deadline.tv_nsec -= 1000000000L;
+	}
+	exit_prompt_shown = true;
+}
+
+static void hide_exit_prompt() {
+	exit_prompt_shown = false;
+	werase(tui.misc_window);
+	render_mark(tui.misc_window);
+	refresh_all();
+}
+
+// milliseconds until the exit prompt goes away, or -1 if it isn't shown
+static int exit_prompt_left_ms() {
+	if (!exit_prompt_shown)
+		return -1;
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	long long ms = (exit_prompt_deadline.tv_sec - now.tv_sec) * 1000LL +
+		(exit_prompt_deadline.tv_nsec - now.tv_nsec) / 1000000L;
+	return ms > 0 ? ms : 0;
+}
+
+static void handle_sigint() {
+	// stopping the emulator happens here, from the loop, between two messages
 	if (client_is_server_executing()) {
 		client_stop_server();
 		return;
 	}
-
-	static bool press_twice;
 	if (tui.focus_window == tui.cli_window) {
 		return;
 	}
+	if (exit_prompt_shown)
+		tui_quit();
+	show_exit_prompt();
+}
 
-	if (press_twice) {
-		endwin();
-		exit(0);
+static void handle_resize() {
+	struct winsize ws;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == -1)
+		return;
+	// the layout is kept; the whole screen is repainted at the new size
+	resizeterm(ws.ws_row, ws.ws_col);
+	clearok(curscr, TRUE);
+	refresh_all();
+}
+
+static void handle_signals() {
+	struct signalfd_siginfo info;
+	while (read(sig_fd, &info, sizeof(info)) == sizeof(info)) {
+		switch (info.ssi_signo) {
+			case SIGINT:
+				handle_sigint();
+				break;
+			case SIGTERM:
+				tui_quit();
+				break;
+			case SIGWINCH:
+				handle_resize();
+				break;
+		}
 	}
+}
 
-	const char *exit_monitor_str = "send ctrl+c again to exit monitor";
-	wborder(tui.misc_window, 0, 0, 0, 0, 0, 0, 0, 0);
-	int max_x, max_y;
-   	getmaxyx(tui.misc_window, max_y, max_x);
-	mvwaddstr(tui.misc_window, max_y/2, max_x/2 - strlen(exit_monitor_str)/2, exit_monitor_str);
-	wrefresh(tui.misc_window);
+// block until `fd` is readable, a signal arrives or `timeout_ms` passes (-1 waits forever).
+// signals are handled before returning, and so is the end of the exit prompt. returns
+// whether `fd` is ready.
+static bool wait_for_events(int fd, int timeout_ms) {
+	int prompt_ms = exit_prompt_left_ms();
+	if (prompt_ms != -1 && (timeout_ms == -1 || prompt_ms < timeout_ms))
+		timeout_ms = prompt_ms;
+
+	struct pollfd fds[] = {
+		{ .fd = sig_fd, .events = POLLIN },
+		{ .fd = fd, .events = POLLIN },
+	};
+	if (poll(fds, 2, timeout_ms) == -1) {
+		if (errno != EINTR)
+			perror("poll()");
+		return false;
+	}
+	if (fds[0].revents & POLLIN)
+		handle_signals();
+	if (exit_prompt_left_ms() == 0)
+		hide_exit_prompt();
+	return fds[1].revents != 0;
+}
 
-	press_twice = true;
-	sleep(3);
-	press_twice = false;
-	wclear(tui.misc_window);
-	wrefresh(tui.misc_window);
+static bool same_instr(const struct instruction *a, const struct instruction *b) {
+	return a->addr == b->addr && a->bank == b->bank;
+}
 
-	refresh_all();
+// the address of an instruction, banked if it lives in the switchable area
+static uint32_t instr_full_addr(const struct instruction *instr) {
+	return ADDR_IS_SWITCHABLE(instr->addr) ? ADDR_BANKED(instr->bank, instr->addr) : instr->addr;
+}
+
+// addresses in the source window are those of the bank on display
+static uint32_t wsrc_view_addr(uint32_t addr) {
+	if (ADDR_IS_SWITCHABLE(addr) && tui.src_window.bank != client_get_mapped_bank())
+		return ADDR_BANKED(tui.src_window.bank, addr);
+	return addr;
 }
 
 static bool is_current_instr_in_instrs() {
 	uintptr_t uiptr_instr;
 	list_for_each(tui.src_window.instrs, uiptr_instr) {
 		struct wsrc_instr *in = (struct wsrc_instr *)uiptr_instr;
-		if (in->instr->addr == tui.src_window.current_instr.instr->addr) {
+		if (same_instr(in->instr, tui.src_window.current_instr.instr)) {
 			return true;
 		}
 	}
 	return false;
 }
 
-static void redraw_reg_window() {
+// returns sp
+static uint32_t draw_cpu_regs() {
 	enum cpu_reg reg_enum = CPU_REG_AF;
 	const char *cpu_regs[] = { "AF: ", "BC: ", "DE: ", "HL: ", "SP: ", "PC: " };
+	// the rows as last drawn; unchanged registers aren't rewritten
+	static char drawn[sizeof(cpu_regs)/sizeof(*cpu_regs)][sizeof(cpu_regs)+6];
+	uint32_t sp = 0;
 
 	for (size_t i = 0; i < sizeof(cpu_regs)/sizeof(char *); i++) {
-		char *cpu_reg_str = reg_to_str(client_get_cpu_reg(reg_enum++)); // we own
+		uint32_t reg = client_get_cpu_reg(reg_enum);
+		if (reg_enum++ == CPU_REG_SP)
+			sp = reg;
+		char *cpu_reg_str = reg_to_str(reg); // we own
 		char buf[sizeof(cpu_regs)+6] = {};
 		strcpy(buf, cpu_regs[i]);
 		strcpy(buf + strlen(cpu_regs[i]), cpu_reg_str);
 
-		mvwaddstr(tui.reg_window, i+1, 1, buf);
-		wrefresh(tui.reg_window);
+		if (strcmp(buf, drawn[i])) {
+			mvwaddstr(tui.reg_window, i+1, 1, buf);
+			strcpy(drawn[i], buf);
+		}
 		free(cpu_reg_str);
 	}
+	render_mark(tui.reg_window);
+	return sp;
+}
+
+#define NUM_CPU_REGS (CPU_REG_PC+1)
+
+// `stopped` when the cpu ran since the last redraw, so that the panels move on to showing
+// what changed in this stop
+static void redraw_reg_window(bool stopped) {
+	uint32_t sp = draw_cpu_regs();
+
+	// the ppu and the rest of the i/o registers come in one read
+	ioregs_update(stopped);
+	int y = ioregs_draw(tui.reg_window, NUM_CPU_REGS+2);
 
-	char *ppu_reg_str = reg_to_str(client_get_ppu_reg(PPU_REG_LY)); // we own
-	const char *s = "ly: ";
-	char buf[sizeof(cpu_regs)+6] = {};
-	strcpy(buf, s);
-	strcpy(buf+strlen(s), ppu_reg_str);
+	// all the watch expressions are evaluated from one batched read
+	watch_update(stopped);
+	y = watch_draw(tui.reg_window, y);
 
-	mvwaddstr(tui.reg_window, (sizeof(cpu_regs)/sizeof(*cpu_regs))+1, 1, buf);
-	wrefresh(tui.reg_window);
-	free(ppu_reg_str);
+	// the stack takes whatever room is left
+	stack_update(sp);
+	stack_draw(tui.reg_window, y+1);
+
+	// the panels' wclrtoeol wiped the right border
+	if (tui.focus_window == tui.reg_window)
+		wborder(tui.reg_window, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
+	else
+		wborder(tui.reg_window, 0, 0, 0, 0, 0, 0, 0, 0);
+	render_mark(tui.reg_window);
 }
 
 static list_t *get_instrs(uint16_t start_addr) {
@@ -212,7 +434,7 @@ static list_t *get_instrs(uint16_t start_addr) {
 			perror("calloc()");
 			goto err2;
 		}
-		wsrc_instr->instr = client_get_instruction(curr_addr);
+		wsrc_instr->instr = client_get_instruction(wsrc_view_addr(curr_addr));
 		if (!wsrc_instr->instr) {
 			goto err2;
 		}
@@ -243,31 +465,175 @@ static struct instruction *get_current_instr() {
 	return client_get_instruction(pc);
 }
 
+// set once the graph around pc has been explored
+static bool cfg_ready;
+
+#define WSRC_MAX_COLS 512
+
+// what each row of the source window shows, as last drawn
+struct wsrc_row {
+	char text[WSRC_MAX_COLS];
+	bool is_highlighted;
+	bool is_current;
+	bool valid;
+};
+
+static struct wsrc_row *wsrc_rows; // one per row inside the border
+
+#define GUTTER_CYCLES_X 15
+#define GUTTER_BLOCK_X 24
+#define GUTTER_COVERAGE_X 3
+
+// cycles of the instructions drawn so far in the current basic block
+struct block_cycles {
+	uint32_t cycles;
+	uint32_t cycles_taken;
+};
+
+static void format_cycles(char *buf, size_t size, uint32_t cycles, uint32_t cycles_taken) {
+	if (cycles == cycles_taken)
+		snprintf(buf, size, "%u", cycles);
+	else
+		snprintf(buf, size, "%u/%u", cycles, cycles_taken);
+}
+
+// copy `str` into the text of a row at window column `col`, clipped to the inside of the window
+static void row_put(char *row, int col, const char *str) {
+	int width = tui.src_window.max_x-2 < WSRC_MAX_COLS-1 ? tui.src_window.max_x-2 : WSRC_MAX_COLS-1;
+	for (; *str && col <= width; col++, str++) {
+		if (col >= 1)
+			row[col-1] = *str;
+	}
+}
+
+// the gutter sits left of the pc marker. it shows the cycles of each instruction, the total of
+// each basic block next to its last instruction, and the share of profile samples.
+static void wsrc_format_gutter(char *row, const struct instruction *instr, struct block_cycles *sum) {
+	struct source_window *wsrc = &tui.src_window;
+	int x = wsrc->max_x/2;
+	char buf[16], field[sizeof(buf)+1]; // room for the '=' in front of a total
+
+	if (x > GUTTER_BLOCK_X) {
+		uint32_t cycles = disasm_op_cycles(instr->bytes, false);
+		uint32_t cycles_taken = disasm_op_cycles(instr->bytes, true);
+		format_cycles(buf, sizeof(buf), cycles, cycles_taken);
+		snprintf(field, sizeof(field), "%5s", buf);
+		row_put(row, x-GUTTER_CYCLES_X, field);
+
+		sum->cycles_taken = sum->cycles + cycles_taken;
+		sum->cycles += cycles;
+
+		// prefer the totals of the cached graph; the running sum misses the part of the block
+		// above the window. right after startup the graph isn't built yet.
+		uint32_t target;
+		const struct cfg_block *blk = cfg_ready ? cfg_get_block(instr_full_addr(instr)) : NULL;
+		if (blk && blk->last == instr->addr) {
+			format_cycles(buf, sizeof(buf), blk->cycles, blk->cycles_taken);
+			snprintf(field, sizeof(field), "=%-7s", buf);
+			row_put(row, x-GUTTER_BLOCK_X, field);
+			*sum = (struct block_cycles){};
+		}
+		else if (disasm_op_flow(instr->bytes, instr->addr, &target) != FLOW_NONE ||
+				(cfg_ready && cfg_is_leader(instr_full_addr(instr) + instr->len))) {
+			format_cycles(buf, sizeof(buf), sum->cycles, sum->cycles_taken);
+			snprintf(field, sizeof(field), "=%-7s", buf);
+			row_put(row, x-GUTTER_BLOCK_X, field);
+			*sum = (struct block_cycles){};
+		}
+	}
+
+	// '+' ran at least once, '.' never did
+	if (x > GUTTER_COVERAGE_X && instr->addr < 2*ROM_BANK_SIZE) {
+		int executed = coverage_get(instr_full_addr(instr));
+		if (executed != -1)
+			row_put(row, x-GUTTER_COVERAGE_X, executed ? "+" : ".");
+	}
+
+	if (!profile_get_total() || !profile_get_count(instr_full_addr(instr)))
+		return;
+	snprintf(field, sizeof(field), "%5.1f%%", profile_get_percent(instr_full_addr(instr)));
+	row_put(row, x-9, field);
+}
+
+// the text of a row without the marker and the highlight: the gutter, the address and the
+// instruction, padded with spaces to the width of the window
+static void wsrc_format_row(char *row, const struct instruction *instr, struct block_cycles *sum) {
+	struct source_window *wsrc = &tui.src_window;
+	int width = wsrc->max_x-2 < WSRC_MAX_COLS-1 ? wsrc->max_x-2 : WSRC_MAX_COLS-1;
+	memset(row, ' ', width);
+	row[width > 0 ? width : 0] = '\0';
+	if (!instr)
+		return;
+
+	char addr[8];
+	snprintf(addr, sizeof(addr), "0x%04x", instr->addr);
+	wsrc_format_gutter(row, instr, sum);
+	row_put(row, wsrc->max_x/2, addr);
+	row_put(row, wsrc->max_x/2+7, instr->str);
+}
+
+// repaint a row only if its text, marker or highlight differ from what was drawn last. with
+// `text` NULL the row keeps its text.
+static void wsrc_draw_row(int y, const struct wsrc_instr *in, const char *text) {
+	struct source_window *wsrc = &tui.src_window;
+	struct wsrc_row *row = &wsrc_rows[y-1];
+	bool is_highlighted = in && in->is_highlighted, is_current = in && in->is_current;
+	if (!text)
+		text = row->text;
+	if (row->valid && row->is_highlighted == is_highlighted && row->is_current == is_current &&
+			(text == row->text || !strcmp(text, row->text)))
+		return;
+
+	int x = wsrc->max_x/2;
+	mvwaddstr(wsrc->win, y, 1, text);
+	if (is_current)
+		mvwaddch(wsrc->win, y, x-2, ACS_DIAMOND);
+	if (is_highlighted) {
+		// the address and the instruction, as far as they fit
+		int last = (int)strlen(text), len = (int)strlen(in->instr->str);
+		if (x+5 <= last)
+			mvwchgat(wsrc->win, y, x, 6, A_REVERSE, 0, NULL);
+		if (x+7 <= last)
+			mvwchgat(wsrc->win, y, x+7, len < last-(x+7)+1 ? len : last-(x+7)+1, A_REVERSE, 0, NULL);
+	}
+
+	if (text != row->text)
+		snprintf(row->text, sizeof(row->text), "%s", text);
+	row->is_highlighted = is_highlighted;
+	row->is_current = is_current;
+	row->valid = true;
+}
+
 static void wsrc_redraw(uint32_t addr) {
 	struct source_window *wsrc = &tui.src_window;
 
 	free(wsrc->instrs);
 	wsrc->instrs = get_instrs(addr); // we own this list
 
-	wclear(wsrc->win);
+	// the border also wipes what's left of a longer title
 	if (wsrc->win == tui.focus_window)
 		wborder(wsrc->win, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
 	else
 		wborder(wsrc->win, 0, 0, 0, 0, 0, 0, 0, 0);
-	wrefresh(wsrc->win);
+	mvwprintw(wsrc->win, 0, 2, " bank %02x%s ", wsrc->bank,
+			wsrc->bank == client_get_mapped_bank() ? "" : " (not mapped)");
 
 	wsrc->longest_str_size = 0;
 
-	// fill the source window with instructions
-	uintptr_t uiptr_instr;
-	int i = 0;
-	list_for_each(wsrc->instrs, uiptr_instr) {
-		struct wsrc_instr *in = (struct wsrc_instr *)uiptr_instr;
-		mvwaddstr(wsrc->win, i+1, wsrc->max_x/2, reg_to_str(in->instr->addr));
-		mvwaddstr(wsrc->win, i+1, (wsrc->max_x/2)+7, in->instr->str);
-		i++;
+	// fill the source window with instructions; only the rows that differ from what's on
+	// display are repainted, e.g. none after a step within the window
+	struct block_cycles sum = {};
+	char text[WSRC_MAX_COLS];
+	for (int y = 1; y < wsrc->max_y-1; y++) {
+		struct wsrc_instr *in = wsrc->instrs ? wsrc->instrs->items[y-1] : NULL;
+		if (in) {
+			in->is_current = same_instr(in->instr, wsrc->current_instr.instr);
+			in->is_highlighted = in->instr->addr == wsrc->current_highlight.addr;
+		}
+		wsrc_format_row(text, in ? in->instr : NULL, &sum);
+		wsrc_draw_row(y, in, text);
 	}
-	wrefresh(wsrc->win);
+	render_mark(wsrc->win);
 }
 
 static void wsrc_highlight_instr(uint32_t addr) {
@@ -276,19 +642,12 @@ static void wsrc_highlight_instr(uint32_t addr) {
 	int i = 0;
 	list_for_each(wsrc->instrs, uiptr_instr) {
 		struct wsrc_instr *in = (struct wsrc_instr *)uiptr_instr;
-		if (in->is_highlighted) {
-			wattroff(wsrc->win, A_REVERSE);
-			mvwaddstr(wsrc->win, i+1, wsrc->max_x/2, reg_to_str(in->instr->addr));
-			mvwaddstr(wsrc->win, i+1, (wsrc->max_x/2)+7, in->instr->str);
-			in->is_highlighted = false;
-		}
-		if (in->instr->addr == addr) {
-			wattron(wsrc->win, A_REVERSE);
-			mvwaddstr(wsrc->win, i+1, wsrc->max_x/2, reg_to_str(in->instr->addr));
-			mvwaddstr(wsrc->win, i+1, (wsrc->max_x/2)+7, in->instr->str);
-			wattroff(wsrc->win, A_REVERSE);
+		bool is_highlighted = in->instr->addr == addr;
+		if (is_highlighted)
 			wsrc->current_highlight = *in->instr;
-			in->is_highlighted = true;
+		if (in->is_highlighted != is_highlighted) {
+			in->is_highlighted = is_highlighted;
+			wsrc_draw_row(i+1, in, NULL);
 		}
 		i++;
 	}
@@ -296,6 +655,7 @@ static void wsrc_highlight_instr(uint32_t addr) {
 
 static void wsrc_move(bool up_down) {
 	struct source_window *wsrc = &tui.src_window;
+	wsrc->scrolled_up = !up_down;
 
 	if ((wsrc->current_pos_y == 1 && up_down == 0) ||
 			(wsrc->current_pos_y == wsrc->max_y-2 && up_down == 1)) {
@@ -311,7 +671,7 @@ static void wsrc_move(bool up_down) {
 				target_addr = 0;
 			}
 			if (first_instr->addr == 2) {
-				struct instruction *instr = client_get_instruction(first_instr->addr-2);
+				struct instruction *instr = client_get_instruction(wsrc_view_addr(first_instr->addr-2));
 				if (instr->len == 2)
 					target_addr = 0;
 				else
@@ -319,12 +679,12 @@ static void wsrc_move(bool up_down) {
 				free(instr);
 			}
 			else {
-				struct instruction *instr = client_get_instruction(first_instr->addr-3);
+				struct instruction *instr = client_get_instruction(wsrc_view_addr(first_instr->addr-3));
 				if (instr->len == 3)
 					target_addr = first_instr->addr-3;
 				else {
 					free(instr);
-					instr = client_get_instruction(first_instr->addr-2);
+					instr = client_get_instruction(wsrc_view_addr(first_instr->addr-2));
 					if (instr->len == 2)
 						target_addr = first_instr->addr-2;
 					else
@@ -353,18 +713,18 @@ static void wsrc_move(bool up_down) {
 static void init_wins() {
 	// source window
 	wborder(tui.src_window.win, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
-	wrefresh(tui.src_window.win);
+	render_mark(tui.src_window.win);
 	tui.src_window.current_pos_y = 1;
 	keypad(tui.src_window.win, true);
 
 	// register window
 	wborder(tui.reg_window, 0, 0, 0, 0, 0, 0, 0, 0);
-	wrefresh(tui.reg_window);
+	render_mark(tui.reg_window);
 
 	// command-line interface window
 	wborder(tui.cli_window, 0, 0, 0, 0, 0, 0, 0, 0);
 	mvwaddstr(tui.cli_window, 1, 1, "> ");
-	wrefresh(tui.cli_window);
+	render_mark(tui.cli_window);
 
 	// help window
 	wborder(tui.help_window, 0, 0, 0, 0, 0, 0, 0, 0);
@@ -372,7 +732,27 @@ static void init_wins() {
 	mvwaddstr(tui.help_window, 2, 2, "Ctrl+C (twice): close debugger");
 	mvwaddstr(tui.help_window, 3, 2, "TAB: change window focus");
 	mvwaddstr(tui.help_window, 4, 2, "j/k: vim-style up and down");
-	wrefresh(tui.help_window);
+	mvwaddstr(tui.help_window, 5, 2, "g/b: follow branch target, go back");
+	mvwaddstr(tui.help_window, 6, 2, "o/f: step over call, finish routine");
+	render_mark(tui.help_window);
+}
+
+static void wsrc_draw_curr_marker() {
+	struct source_window *wsrc = &tui.src_window;
+
+	uintptr_t uiptr_instr;
+	int i = 0;
+	list_for_each(wsrc->instrs, uiptr_instr) {
+		struct wsrc_instr *in = (struct wsrc_instr *)uiptr_instr;
+		bool is_current = same_instr(in->instr, wsrc->current_instr.instr);
+		if (is_current)
+			wsrc->current_pos_y = i+1;
+		if (in->is_current != is_current) {
+			in->is_current = is_current;
+			wsrc_draw_row(i+1, in, NULL);
+		}
+		i++;
+	}
 }
 
 static void wsrc_set_curr_instr(uint32_t addr) {
@@ -381,52 +761,344 @@ static void wsrc_set_curr_instr(uint32_t addr) {
 	free(tui.src_window.current_instr.instr);
 	wsrc->current_instr.instr = client_get_instruction(addr);
 
-	if (!is_current_instr_in_instrs())
+	if (!is_current_instr_in_instrs()) {
+		wsrc->bank = client_get_mapped_bank();
 		wsrc_redraw(wsrc->current_instr.instr->addr);
+	}
 
-	uintptr_t uiptr_instr;
-	int i = 0;
-	list_for_each(tui.src_window.instrs, uiptr_instr) {
-		struct wsrc_instr *in = (struct wsrc_instr *)uiptr_instr;
-		if (in->is_current) {
-			in->is_current = false;
-			mvwaddch(wsrc->win, i+1, (wsrc->max_x/2)-2, ' ');
+	wsrc_draw_curr_marker();
+}
+
+void tui_reg_refresh() {
+	redraw_reg_window(false);
+}
+
+// redraw the instructions currently on display, e.g. when the gutter contents change
+void tui_src_refresh() {
+	struct source_window *wsrc = &tui.src_window;
+	struct instruction *first_instr = ((struct wsrc_instr*)wsrc->instrs->items[0])->instr;
+	int pos_y = wsrc->current_pos_y;
+
+	wsrc_redraw(first_instr->addr);
+	wsrc_draw_curr_marker();
+	wsrc->current_pos_y = pos_y;
+	wsrc_highlight_instr(wsrc->current_highlight.addr);
+	render_mark(wsrc->win);
+}
+
+// `addr` may be banked to show code from a bank that isn't mapped
+void tui_src_goto(uint32_t addr) {
+	struct source_window *wsrc = &tui.src_window;
+
+	if (ADDR_IS_BANKED(addr) && ADDR_IS_SWITCHABLE(addr))
+		wsrc->bank = ADDR_BANK(addr);
+	else if (ADDR_IS_SWITCHABLE(addr))
+		wsrc->bank = client_get_mapped_bank();
+	addr = ADDR_OFFSET(addr);
+
+	wsrc_redraw(addr);
+	wsrc_draw_curr_marker();
+	wsrc->current_pos_y = 1;
+	wsrc_highlight_instr(addr);
+	render_mark(wsrc->win);
+}
+
+// nanoseconds from now until deadline, 0 once it has passed
+static long long ns_until(const struct timespec *deadline) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	long long ns = (deadline->tv_sec - now.tv_sec) * 1000000000LL + (deadline->tv_nsec - now.tv_nsec);
+	return ns > 0 ? ns : 0;
+}
+
+// while profiling, the emulator is briefly stopped at every sampling period to read its pc.
+// this costs a few round trips per sample, but needs nothing from the emulator besides the
+// usual stop/resume messages.
+static void sample_until_stop() {
+	long long period_ns = 1000000000LL / profile_get_rate();
+
+	while (client_is_server_executing()) {
+		// the period runs from the resume, the pause before it isn't part of it
+		struct timespec deadline;
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += period_ns / 1000000000LL;
+		deadline.tv_nsec += period_ns % 1000000000LL;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
 		}
-		if (in->instr->addr == addr) {
-			in->is_current = true;
-			mvwaddch(wsrc->win, i+1, (wsrc->max_x/2)-2, ACS_DIAMOND);
-			wsrc->current_pos_y = i+1;
+		// wait out the period like halt_and_wait does: a ctrl+c stops the emulator right
+		// away, and so does a stop of its own (breakpoint, until...)
+		long long left_ns;
+		while (client_is_server_executing() && (left_ns = ns_until(&deadline)) > 0) {
+			int timeout_ms = (left_ns + 999999) / 1000000;
+			if (render_is_pending() && timeout_ms > 1000 / RENDER_MAX_FPS)
+				timeout_ms = 1000 / RENDER_MAX_FPS;
+			if (wait_for_events(client_get_fd(), timeout_ms) &&
+					!client_recv_msg_and_dispatch(true))
+				return;
+			while (client_is_server_executing() && client_recv_msg_and_dispatch(false))
+				;
+			render_flush_capped(NULL);
 		}
-		i++;
+		if (!client_is_server_executing())
+			break;
+		client_stop_server();
+		// a stop of the emulator's own may have crossed with ours. the server handles messages
+		// in order, so by the time the pc arrives any such stop has been dispatched; resuming
+		// after it would run past the breakpoint
+		while (client_recv_msg_and_dispatch(false))
+			;
+		uint32_t pc = get_pc();
+		if (client_server_stopped_itself())
+			break;
+		profile_add_sample(ADDR_IS_SWITCHABLE(pc) ? ADDR_BANKED(client_get_mapped_bank(), pc) : pc);
+		client_resume_server();
 	}
 }
 
+// bring the source and register windows up to date after the emulator stopped
+static bool explored_entries;
+
+// after startup, the panels and the graph are filled in while waiting for input, one step
+// at a time so that a key press is never held up for long
+enum warm_step {
+	WARM_PANELS,
+	WARM_CFG,
+	WARM_CFG_ENTRIES,
+	WARM_DONE,
+};
+static enum warm_step warm_step = WARM_DONE;
+
+static void warm_caches_step() {
+	switch (warm_step) {
+		case WARM_PANELS:
+			redraw_reg_window(false);
+			break;
+		case WARM_CFG:
+			if (!cfg_ready) {
+				cfg_explore(get_pc());
+				cfg_ready = true;
+				// the gutter can show block totals now
+				tui_src_refresh();
+			}
+			break;
+		case WARM_CFG_ENTRIES:
+			if (!explored_entries)
+				explored_entries = cfg_explore_entries() != -1;
+			break;
+		case WARM_DONE:
+			return;
+	}
+	warm_step++;
+}
+
+// bytes of code to fetch with the state: enough for a full source window
+static uint32_t wsrc_code_len() {
+	return (tui.src_window.max_y-2) * 3;
+}
+
+// the views likely to come next are read ahead while waiting for input, one request per
+// idle poll. a key press drops whatever is left and the queue is planned again from wherever
+// the view ends up.
+#define PREFETCH_QUEUE_MAX 3
+
+struct prefetch_req {
+	uint32_t addr, len;
+};
+
+static struct prefetch_req prefetch_queue[PREFETCH_QUEUE_MAX];
+static size_t prefetch_len, prefetch_next;
+
+static void prefetch_cancel() {
+	prefetch_len = prefetch_next = 0;
+}
+
+static void prefetch_push(uint32_t addr, uint32_t len) {
+	if (prefetch_len < PREFETCH_QUEUE_MAX)
+		prefetch_queue[prefetch_len++] = (struct prefetch_req){ addr, len };
+}
+
+static void prefetch_plan() {
+	struct source_window *wsrc = &tui.src_window;
+	uint32_t page = wsrc_code_len(), target;
+
+	prefetch_cancel();
+	if (client_is_server_executing() || !wsrc->instrs)
+		return;
+
+	// the next page in the direction we've been scrolling, along with what's on display,
+	// since scrolling redraws the whole window
+	struct instruction *first = ((struct wsrc_instr *)wsrc->instrs->items[0])->instr;
+	struct instruction *last = ((struct wsrc_instr *)wsrc->instrs->items[wsrc->max_y-3])->instr;
+	uint32_t end = last->addr + last->len;
+	if (wsrc->scrolled_up) {
+		uint32_t start = first->addr > page ? first->addr - page : 0;
+		prefetch_push(wsrc_view_addr(start), end - start);
+	}
+	else {
+		prefetch_push(wsrc_view_addr(first->addr), end + page - first->addr);
+	}
+
+	// the target of the branch under the highlight, for 'g'
+	enum disasm_flow flow = disasm_op_flow(wsrc->current_highlight.bytes,
+			wsrc->current_highlight.addr, &target);
+	if (flow == FLOW_JUMP || flow == FLOW_JUMP_COND || flow == FLOW_CALL ||
+			flow == FLOW_CALL_COND || flow == FLOW_RST) {
+		if (wsrc->current_highlight.bank && ADDR_IS_SWITCHABLE(target))
+			target = ADDR_BANKED(wsrc->current_highlight.bank, target);
+		prefetch_push(target, page);
+	}
+
+	// what follows pc, for stepping
+	prefetch_push(get_pc(), 2*page);
+}
+
+// returns false if there's nothing left to read
+static bool prefetch_step() {
+	if (prefetch_next == prefetch_len)
+		return false;
+	client_prefetch_code(prefetch_queue[prefetch_next].addr, prefetch_queue[prefetch_next].len);
+	prefetch_next++;
+	return true;
+}
+
+void tui_show_stop_state() {
+	// registers and the code at pc come in one request, if the server supports it
+	client_get_state(wsrc_code_len());
+	uint32_t pc = get_pc();
+
+	if (coverage_is_enabled())
+		coverage_update();
+
+	// code in ram may have changed while running
+	cfg_invalidate();
+	if (!explored_entries)
+		explored_entries = cfg_explore_entries() != -1;
+	cfg_explore(pc);
+	cfg_ready = true;
+
+	wsrc_set_curr_instr(pc);
+	wsrc_highlight_instr(tui.src_window.current_instr.instr->addr);
+	redraw_reg_window(true);
+
+	// the viewer needs the palette and lcdc from the register panel
+	if (vram_is_visible()) {
+		vram_update();
+		vram_redraw(tui.focus_window == tui.vram_window);
+	}
+
+	prefetch_plan();
+}
+
 static void halt_and_wait() {
+	stack_invalidate();
+	// the popup below takes the place of the exit prompt
+	exit_prompt_shown = false;
 	const char *stop_server_str = "emulator is executing. ctrl+c to stop execution.";
 	wborder(tui.misc_window, 0, 0, 0, 0, 0, 0, 0, 0);
 	int max_x, max_y;
 	getmaxyx(tui.misc_window, max_y, max_x);
 	mvwaddstr(tui.misc_window, max_y/2, max_x/2 - strlen(stop_server_str)/2, stop_server_str);
-	wrefresh(tui.misc_window);
+	render_mark(tui.misc_window);
+	render_flush(NULL);
 
-	client_recv_msg_and_dispatch(true);
+	if (profile_is_enabled())
+		sample_until_stop();
+	else {
+		// status records keep coming until the stop message. the wait also wakes up for a
+		// ctrl+c, and for pending screen updates the frame cap held back
+		while (client_is_server_executing()) {
+			int timeout_ms = render_is_pending() ? 1000 / RENDER_MAX_FPS : -1;
+			if (wait_for_events(client_get_fd(), timeout_ms) &&
+					!client_recv_msg_and_dispatch(true))
+				break;
+			// whatever else already arrived
+			while (client_is_server_executing() && client_recv_msg_and_dispatch(false))
+				;
+			render_flush_capped(NULL);
+		}
+	}
 
-	wclear(tui.misc_window);
-	wrefresh(tui.misc_window);
+	werase(tui.misc_window);
+	render_mark(tui.misc_window);
 	refresh_all();
 
-	wsrc_set_curr_instr(get_pc());
-	wsrc_highlight_instr(tui.src_window.current_instr.instr->addr);
-	redraw_reg_window();
+	tui_show_stop_state();
 }
 
 static void do_control_flow_next() {
-	struct source_window *wsrc = &tui.src_window;
-
+	stack_note_step(tui.src_window.current_instr.instr->bytes);
 	client_control_flow_next();
-	wsrc_set_curr_instr(get_pc());
-	wsrc_highlight_instr(wsrc->current_instr.instr->addr);
-	redraw_reg_window();
+	tui_show_stop_state();
+}
+
+static int read_instr_bytes(uint32_t addr, uint8_t *bytes) {
+	const uint8_t *mem = cfg_get_mem(addr);
+	if (mem) {
+		memcpy(bytes, mem, 3);
+		return 0;
+	}
+	memset(bytes, 0, 3);
+	return client_read_mem(addr, addr > 0xfffd ? 0x10000-addr : 3, bytes);
+}
+
+// stepping over a call is a single until to the instruction after it, so the whole
+// subroutine runs on the server in one round trip.
+void tui_step_over() {
+	uint32_t pc = get_pc(), target;
+	uint8_t bytes[3];
+	if (read_instr_bytes(pc, bytes) == -1)
+		return;
+
+	switch (disasm_op_flow(bytes, pc, &target)) {
+		case FLOW_CALL:
+		case FLOW_CALL_COND:
+		case FLOW_RST:
+			client_control_flow_until((pc + disasm_op_len(bytes[0])) & 0xffff);
+			break;
+		default:
+			do_control_flow_next();
+	}
+}
+
+#define FINISH_MAX_STACK_WORDS 16
+
+// a word on the stack is taken as a return address if the instruction right before it is
+// a call or a rst; walking up from sp skips whatever the routine pushed since it was called.
+static int find_return_addr(uint32_t *ret) {
+	uint8_t stack[FINISH_MAX_STACK_WORDS*2];
+	uint32_t sp = client_get_cpu_reg(CPU_REG_SP);
+	uint32_t len = 0x10000 - sp < sizeof(stack) ? 0x10000 - sp : sizeof(stack);
+	if (client_read_mem(sp, len, stack) == -1)
+		return -1;
+
+	for (uint32_t i = 0; i+1 < len; i += 2) {
+		uint32_t addr = stack[i] | stack[i+1] << 8, target;
+		uint8_t bytes[3];
+		if (addr >= 3 && read_instr_bytes(addr-3, bytes) != -1) {
+			enum disasm_flow flow = disasm_op_flow(bytes, addr-3, &target);
+			if (flow == FLOW_CALL || flow == FLOW_CALL_COND) {
+				*ret = addr;
+				return 0;
+			}
+		}
+		if (addr >= 1 && read_instr_bytes(addr-1, bytes) != -1 &&
+				disasm_op_flow(bytes, addr-1, &target) == FLOW_RST) {
+			*ret = addr;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+void tui_finish() {
+	uint32_t ret;
+	if (find_return_addr(&ret) == -1) {
+		cli_printf("finish: no return address found on the stack");
+		return;
+	}
+	client_control_flow_until(ret);
 }
 
 static void wsrc_handle_input(int input_char) {
@@ -441,13 +1113,43 @@ static void wsrc_handle_input(int input_char) {
 	else if (input_char == '\n') {
 		// either target the highlighted instruction if the user selected one in the TUI, or
 		// else just target the next instruction.
-		if (wsrc->current_highlight.addr != wsrc->current_instr.instr->addr) {
-			client_control_flow_until(wsrc->current_highlight.addr);
+		if (!same_instr(&wsrc->current_highlight, wsrc->current_instr.instr)) {
+			client_control_flow_until(instr_full_addr(&wsrc->current_highlight));
 		}
 		else {
 			do_control_flow_next();
 		}
 	}
+	else if (input_char == 'o') {
+		tui_step_over();
+	}
+	else if (input_char == 'f') {
+		tui_finish();
+	}
+	else if (input_char == 'g') {
+		// follow the jump or call under the highlight; the target is decoded locally
+		uint32_t target;
+		enum disasm_flow flow = disasm_op_flow(wsrc->current_highlight.bytes,
+				wsrc->current_highlight.addr, &target);
+		if (flow == FLOW_JUMP || flow == FLOW_JUMP_COND || flow == FLOW_CALL ||
+				flow == FLOW_CALL_COND || flow == FLOW_RST) {
+			size_t max_jumps = sizeof(wsrc->jump_history)/sizeof(*wsrc->jump_history);
+			if (wsrc->num_jumps == max_jumps) {
+				memmove(wsrc->jump_history, wsrc->jump_history+1,
+						(max_jumps-1) * sizeof(*wsrc->jump_history));
+				wsrc->num_jumps--;
+			}
+			wsrc->jump_history[wsrc->num_jumps++] = instr_full_addr(&wsrc->current_highlight);
+			// from banked code, targets in the switchable area are in the same bank
+			if (wsrc->current_highlight.bank && ADDR_IS_SWITCHABLE(target))
+				target = ADDR_BANKED(wsrc->current_highlight.bank, target);
+			tui_src_goto(target);
+		}
+	}
+	else if (input_char == 'b') {
+		if (wsrc->num_jumps)
+			tui_src_goto(wsrc->jump_history[--wsrc->num_jumps]);
+	}
 }
 
 static void interpret_input(int input_char) {
@@ -457,43 +1159,96 @@ static void interpret_input(int input_char) {
 	else if (tui.focus_window == tui.src_window.win) {
 		wsrc_handle_input(input_char);
 	}
+	else if (tui.focus_window == tui.results_window) {
+		results_handle_input(input_char);
+		if (!results_is_visible()) {
+			// the pane was closed; give the focus back to the source window
+			tui.focus_window = tui.src_window.win;
+			wborder(tui.focus_window, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
+			refresh_all();
+		}
+	}
+	else if (tui.focus_window == tui.vram_window) {
+		vram_handle_input(input_char);
+		if (!vram_is_visible()) {
+			tui.focus_window = tui.src_window.win;
+			wborder(tui.focus_window, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
+			refresh_all();
+		}
+	}
 }
 
 int tui_run() {
 	noecho();
 	curs_set(0);
 
-	// we handle SIGINT so that the user can ctrl+c to quit
-	struct sigaction sig = { .sa_handler = sigint_handler, .sa_flags = SA_NODEFER };
-	sigaction(SIGINT, &sig, NULL);
+	// ctrl+c stops the emulator or quits; it's read by the loop below with the rest of input
+	if (signals_init() == -1)
+		return -1;
 
 	// send a MONITOR_STOP message to server
 	client_stop_server();
+	client_subscribe_status(STATUS_RATE);
+
+	// the first screen is painted from a single request; everything else is warmed up
+	// while waiting for input
+	client_get_state(wsrc_code_len());
+	cfg_set_bank(client_get_mapped_bank());
+	tui.src_window.bank = client_get_mapped_bank();
+	// the graph from earlier sessions with this rom, if there were any
+	if (cfgcache_open() == 1)
+		cfg_ready = true;
 
 	tui.src_window.current_instr.instr = get_current_instr();
 	tui.src_window.current_highlight = *tui.src_window.current_instr.instr;
 
-	wsrc_redraw(0);
-	wsrc_set_curr_instr(get_pc());
+	wsrc_redraw(tui.src_window.current_instr.instr->addr);
+	wsrc_draw_curr_marker();
 	wsrc_highlight_instr(tui.src_window.current_instr.instr->addr);
-	redraw_reg_window();
+	draw_cpu_regs();
+	warm_step = WARM_PANELS;
+	prefetch_plan();
 
 	while (1) {
 		if (client_is_server_executing()) {
 			halt_and_wait();
 		}
 
-		// we parse on a char-by-char basis
+		// we parse on a char-by-char basis. input is never waited for in wgetch, but in
+		// wait_for_events together with signals
+		bool idle_work = warm_step != WARM_DONE || prefetch_next < prefetch_len ||
+			cfgcache_is_dirty();
+		wtimeout(tui.focus_window, 0);
+		// everything drawn since the last input goes out in one update
+		render_flush(tui.focus_window);
 		int input_char = wgetch(tui.focus_window);
+		if (input_char == KEY_RESIZE)
+			continue;
+		if (input_char == ERR) {
+			// while there's idle work left, only check for signals
+			wait_for_events(STDIN_FILENO, idle_work ? 0 : -1);
+			if (!idle_work || client_is_server_executing())
+				continue;
+			// the panels first, then the likely next views, then the rest of the graph, and
+			// last whatever the graph gained goes to the on-disk cache
+			if (warm_step == WARM_PANELS || !prefetch_step()) {
+				if (warm_step != WARM_DONE)
+					warm_caches_step();
+				else if (cfgcache_is_dirty())
+					cfgcache_save();
+			}
+			continue;
+		}
+		prefetch_cancel();
 
 		// TAB changes the focused window
 		if (input_char == '\t') {
 			change_focus();
-			continue;
 		}
 		else {
 			interpret_input(input_char);
 		}
+		prefetch_plan();
 	}
 
 	endwin();
@@ -501,6 +1256,7 @@ int tui_run() {
 }
 
 struct dispatch_table *tui_init() {
+	setlocale(LC_ALL, "");
 	initscr();
 
 	if (!(tui.cli_window = cli_init())) {
@@ -511,6 +1267,10 @@ struct dispatch_table *tui_init() {
 		goto err;
 	}
 	getmaxyx(tui.src_window.win, tui.src_window.max_y, tui.src_window.max_x);
+	if (!(wsrc_rows = calloc(tui.src_window.max_y, sizeof(*wsrc_rows)))) {
+		perror("calloc()");
+		goto err;
+	}
 
 	if (!(tui.reg_window = newwin((LINES/3)*2+(LINES%3), COLS/2, 0, COLS/2))) {
 		perror("newwin()");
@@ -521,6 +1281,18 @@ struct dispatch_table *tui_init() {
 		goto err;
 	}
 
+	// the results pane shares its place with the help window
+	if (!(tui.results_window = results_init(newwin(LINES/3, COLS/2, LINES-(LINES/3), COLS/2)))) {
+		perror("newwin()");
+		goto err;
+	}
+
+	// the vram viewer is drawn over the source window
+	if (!(tui.vram_window = vram_init(newwin((LINES/3)*2+(LINES%3), COLS/2, 0, 0)))) {
+		perror("newwin()");
+		goto err;
+	}
+
 	// this window is used as a popup to display messages
 	if (!(tui.misc_window = newwin(5, COLS/3, LINES/3, COLS/3))) {
 		perror("newwin()");
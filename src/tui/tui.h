@@ -23,5 +23,11 @@
 
 struct dispatch_table *tui_init();
 int tui_run();
+void tui_src_goto(uint32_t addr);
+void tui_src_refresh();
+void tui_reg_refresh();
+void tui_show_stop_state();
+void tui_step_over();
+void tui_finish();
 
 #endif
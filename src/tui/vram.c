@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// half blocks and shades need the wide-character api
+#define NCURSES_WIDECHAR 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "client.h"
+#include "ioregs.h"
+#include "render.h"
+#include "vram.h"
+
+#define TILE_BYTES 16
+#define TILES_PER_ROW 16
+#define MAP_SIZE 32
+#define MAP_ENTRIES (MAP_SIZE*MAP_SIZE)
+
+// each cell shows two pixels stacked with an upper half block: the foreground is the upper
+// pixel and the background the lower one, so a tile takes 8 columns by 4 rows.
+#define TILE_COLS 8
+#define TILE_ROWS 4
+
+// one colour pair per (upper shade, lower shade)
+#define PAIR_BASE 16
+
+// the viewer renders into one pad per view. every tile is hashed after the bulk read, and a
+// pad cell block is redrawn only if the hash of the tile drawn there differs, so stepping
+// through code that touches a few tiles re-emits only those to the terminal.
+struct vram_pad {
+	WINDOW *pad;
+	int rows, cols;
+	int top, left;
+	uint64_t drawn[MAP_ENTRIES]; // hash of the tile drawn at each slot, 0 if none
+	int drawn_bgp;
+};
+
+struct vram_window {
+	WINDOW *win;
+	int max_y, max_x;
+	bool visible;
+	bool colors;
+	enum vram_view view;
+	struct vram_pad pads[VRAM_NUM_VIEWS];
+};
+static struct vram_window wvram;
+
+// points into the shared memory of the server when there is one, else to our own copy
+static const uint8_t *vram;
+static uint8_t vram_copy[VRAM_SIZE];
+static uint64_t tile_hash[VRAM_NUM_TILES];
+static bool has_vram;
+
+static uint64_t hash_tile(const uint8_t *tile) {
+	uint64_t h = 0xcbf29ce484222325ull;
+	for (int i = 0; i < TILE_BYTES; i++) {
+		h ^= tile[i];
+		h *= 0x100000001b3ull;
+	}
+	// 0 means nothing drawn
+	return h | 1;
+}
+
+int vram_update() {
+	vram = client_get_mem_view(VRAM_BASE, VRAM_SIZE);
+	if (!vram) {
+		if (client_read_mem(VRAM_BASE, VRAM_SIZE, vram_copy) == -1) {
+			has_vram = false;
+			return -1;
+		}
+		vram = vram_copy;
+	}
+	for (int i = 0; i < VRAM_NUM_TILES; i++)
+		tile_hash[i] = hash_tile(&vram[i*TILE_BYTES]);
+	has_vram = true;
+	return 0;
+}
+
+static void draw_cell(WINDOW *pad, int y, int x, int upper, int lower) {
+	static const wchar_t *shades[] = { L" ", L"\u2591", L"\u2592", L"\u2588" };
+	cchar_t cc;
+	if (wvram.colors)
+		setcchar(&cc, L"\u2580", A_NORMAL, PAIR_BASE + upper*4 + lower, NULL);
+	else
+		setcchar(&cc, shades[upper > lower ? upper : lower], A_NORMAL, 0, NULL);
+	mvwadd_wch(pad, y, x, &cc);
+}
+
+static void draw_tile(WINDOW *pad, int y, int x, int tile, uint8_t bgp) {
+	const uint8_t *data = &vram[tile*TILE_BYTES];
+	for (int row = 0; row < TILE_ROWS; row++) {
+		const uint8_t *upper = &data[row*4], *lower = &data[row*4+2];
+		for (int col = 0; col < TILE_COLS; col++) {
+			int bit = 7-col;
+			int cu = (upper[1] >> bit & 1) << 1 | (upper[0] >> bit & 1);
+			int cl = (lower[1] >> bit & 1) << 1 | (lower[0] >> bit & 1);
+			draw_cell(pad, y+row, x+col, bgp >> cu*2 & 3, bgp >> cl*2 & 3);
+		}
+	}
+}
+
+// tile data used by the maps depends on lcdc bit 4: 0x8000 with unsigned indices, or 0x9000
+// with signed ones
+static int map_tile(uint8_t lcdc, uint8_t idx) {
+	return lcdc & 0x10 ? idx : 256 + (int8_t)idx;
+}
+
+static void render(enum vram_view view) {
+	struct vram_pad *p = &wvram.pads[view];
+	int bgp = ioregs_get(0xff47), lcdc = ioregs_get(0xff40);
+	if (bgp == -1)
+		bgp = 0xe4;
+	if (lcdc == -1)
+		lcdc = 0x91;
+
+	if (bgp != p->drawn_bgp) {
+		memset(p->drawn, 0, sizeof(p->drawn));
+		p->drawn_bgp = bgp;
+	}
+
+	if (view == VRAM_VIEW_TILES) {
+		for (int i = 0; i < VRAM_NUM_TILES; i++) {
+			if (p->drawn[i] == tile_hash[i])
+				continue;
+			draw_tile(p->pad, i/TILES_PER_ROW*TILE_ROWS, i%TILES_PER_ROW*TILE_COLS, i, bgp);
+			p->drawn[i] = tile_hash[i];
+		}
+		return;
+	}
+
+	uint8_t map_bit = view == VRAM_VIEW_BG ? 0x08 : 0x40;
+	const uint8_t *map = &vram[(lcdc & map_bit ? 0x9c00 : 0x9800) - VRAM_BASE];
+	for (int i = 0; i < MAP_ENTRIES; i++) {
+		int tile = map_tile(lcdc, map[i]);
+		// the slot is keyed by the hash of its tile, so both a new index and new tile
+		// data in the same place redraw it
+		if (p->drawn[i] == tile_hash[tile])
+			continue;
+		draw_tile(p->pad, i/MAP_SIZE*TILE_ROWS, i%MAP_SIZE*TILE_COLS, tile, bgp);
+		p->drawn[i] = tile_hash[tile];
+	}
+}
+
+void vram_redraw(bool focused) {
+	static const char *titles[] = {
+		[VRAM_VIEW_TILES] = "vram tiles",
+		[VRAM_VIEW_BG] = "bg map",
+		[VRAM_VIEW_WIN] = "window map",
+	};
+	if (!wvram.visible)
+		return;
+
+	struct vram_pad *p = &wvram.pads[wvram.view];
+	if (has_vram)
+		render(wvram.view);
+
+	if (focused)
+		wborder(wvram.win, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD, ACS_CKBOARD);
+	else
+		wborder(wvram.win, 0, 0, 0, 0, 0, 0, 0, 0);
+	mvwprintw(wvram.win, 0, 2, " %s ", titles[wvram.view]);
+	mvwprintw(wvram.win, wvram.max_y-1, 2, " t/m/w: tiles, bg, window  hjkl: scroll  q: close ");
+	render_mark(wvram.win);
+
+	int begin_y, begin_x;
+	getbegyx(wvram.win, begin_y, begin_x);
+	render_mark_pad(p->pad, p->top, p->left, begin_y+1, begin_x+1,
+			begin_y+wvram.max_y-2, begin_x+wvram.max_x-2);
+}
+
+static void scroll_pad(int dy, int dx) {
+	struct vram_pad *p = &wvram.pads[wvram.view];
+	int max_top = p->rows - (wvram.max_y-2), max_left = p->cols - (wvram.max_x-2);
+	p->top += dy;
+	p->left += dx;
+	if (p->top > max_top)
+		p->top = max_top;
+	if (p->left > max_left)
+		p->left = max_left;
+	if (p->top < 0)
+		p->top = 0;
+	if (p->left < 0)
+		p->left = 0;
+}
+
+void vram_handle_input(int ch) {
+	switch (ch) {
+		case 'j':
+			scroll_pad(TILE_ROWS, 0);
+			break;
+		case 'k':
+			scroll_pad(-TILE_ROWS, 0);
+			break;
+		case 'l':
+			scroll_pad(0, TILE_COLS);
+			break;
+		case 'h':
+			scroll_pad(0, -TILE_COLS);
+			break;
+		case KEY_NPAGE:
+			scroll_pad(wvram.max_y-2, 0);
+			break;
+		case KEY_PPAGE:
+			scroll_pad(-(wvram.max_y-2), 0);
+			break;
+		case 't':
+			wvram.view = VRAM_VIEW_TILES;
+			break;
+		case 'm':
+			wvram.view = VRAM_VIEW_BG;
+			break;
+		case 'w':
+			wvram.view = VRAM_VIEW_WIN;
+			break;
+		case 'q':
+			vram_hide();
+			return;
+	}
+	vram_redraw(true);
+}
+
+void vram_show(enum vram_view view) {
+	wvram.view = view;
+	wvram.visible = true;
+	if (!has_vram)
+		vram_update();
+	vram_redraw(false);
+}
+
+void vram_hide() {
+	wvram.visible = false;
+	// updates stop while hidden, so read it again on the next show
+	has_vram = false;
+}
+
+bool vram_is_visible() {
+	return wvram.visible;
+}
+
+// dmg-like greens from the 256-colour cube, lightest first
+static const short shade_colors[] = { 193, 107, 65, 22 };
+static const short shade_colors_8[] = { COLOR_WHITE, COLOR_GREEN, COLOR_BLUE, COLOR_BLACK };
+
+WINDOW *vram_init(WINDOW *win) {
+	if (!win)
+		return NULL;
+
+	wvram.win = win;
+	getmaxyx(wvram.win, wvram.max_y, wvram.max_x);
+	keypad(wvram.win, true);
+
+	if (has_colors() && start_color() == OK) {
+		const short *shades = COLORS >= 256 ? shade_colors : shade_colors_8;
+		for (int upper = 0; upper < 4; upper++) {
+			for (int lower = 0; lower < 4; lower++)
+				init_pair(PAIR_BASE + upper*4 + lower, shades[upper], shades[lower]);
+		}
+		wvram.colors = COLOR_PAIRS > PAIR_BASE + 16;
+	}
+
+	const int sizes[][2] = {
+		[VRAM_VIEW_TILES] = { VRAM_NUM_TILES/TILES_PER_ROW*TILE_ROWS, TILES_PER_ROW*TILE_COLS },
+		[VRAM_VIEW_BG] = { MAP_SIZE*TILE_ROWS, MAP_SIZE*TILE_COLS },
+		[VRAM_VIEW_WIN] = { MAP_SIZE*TILE_ROWS, MAP_SIZE*TILE_COLS },
+	};
+	for (int i = 0; i < VRAM_NUM_VIEWS; i++) {
+		struct vram_pad *p = &wvram.pads[i];
+		p->rows = sizes[i][0];
+		p->cols = sizes[i][1];
+		p->drawn_bgp = -1;
+		if (!(p->pad = newpad(p->rows, p->cols))) {
+			perror("newpad()");
+			return NULL;
+		}
+	}
+
+	return wvram.win;
+}
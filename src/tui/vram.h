@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef VRAM_H
+#define VRAM_H
+
+#include <ncurses.h>
+
+#define VRAM_BASE 0x8000
+#define VRAM_SIZE 0x2000
+#define VRAM_NUM_TILES 384
+
+enum vram_view {
+	VRAM_VIEW_TILES,
+	VRAM_VIEW_BG,
+	VRAM_VIEW_WIN,
+	VRAM_NUM_VIEWS,
+};
+
+WINDOW *vram_init(WINDOW *win);
+int vram_update();
+void vram_show(enum vram_view view);
+void vram_hide();
+bool vram_is_visible();
+void vram_redraw(bool focused);
+void vram_handle_input(int ch);
+
+#endif
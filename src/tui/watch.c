@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "client.h"
+#include "expr.h"
+#include "watch.h"
+
+// loads whose addresses come from other loads ([[hl]]) need another read; nesting deeper
+// than this is left unevaluated
+#define WATCH_MAX_ROUNDS 4
+
+// expressions are compiled when added. at every stop, the loads of all of them are fetched
+// together in one batched read per level of nesting, i.e. one read in the common case.
+struct watch {
+	char text[WATCH_MAX_TEXT];
+	struct expr expr;
+	struct expr_load loads[EXPR_MAX_LOADS];
+	uint32_t val, prev_val;
+	bool known, prev_known;
+};
+
+static struct watch watches[WATCH_MAX];
+static size_t num_watches;
+
+static struct client_mem_range ranges[WATCH_MAX * EXPR_MAX_LOADS];
+static struct expr_load *pending[WATCH_MAX * EXPR_MAX_LOADS];
+static uint8_t batch[WATCH_MAX * EXPR_MAX_LOADS * 2];
+
+int watch_add(const char *text) {
+	if (num_watches == WATCH_MAX)
+		return -1;
+	struct watch *w = &watches[num_watches];
+	if (expr_compile(text, &w->expr) == -1)
+		return -1;
+	snprintf(w->text, sizeof(w->text), "%s", text);
+	w->known = w->prev_known = false;
+	num_watches++;
+	return 0;
+}
+
+int watch_remove(size_t idx) {
+	if (idx >= num_watches)
+		return -1;
+	memmove(&watches[idx], &watches[idx+1], (num_watches-idx-1) * sizeof(*watches));
+	num_watches--;
+	return 0;
+}
+
+void watch_clear() {
+	num_watches = 0;
+}
+
+size_t watch_get_count() {
+	return num_watches;
+}
+
+// `stopped` if the cpu ran since the last update. otherwise the watches are only evaluated
+// again, e.g. after one was added, and the changes shown are still those of the last stop
+int watch_update(bool stopped) {
+	if (!num_watches)
+		return 0;
+
+	uint32_t regs[CPU_REG_PC+1];
+	for (enum cpu_reg r = CPU_REG_AF; r <= CPU_REG_PC; r++)
+		regs[r] = client_get_cpu_reg(r);
+	for (size_t i = 0; i < num_watches; i++) {
+		struct watch *w = &watches[i];
+		if (stopped) {
+			w->prev_val = w->val;
+			w->prev_known = w->known;
+		}
+		w->known = false;
+		expr_reset_loads(&w->expr, w->loads);
+	}
+
+	for (int round = 0; ; round++) {
+		size_t num = 0;
+		for (size_t i = 0; i < num_watches; i++) {
+			struct watch *w = &watches[i];
+			if (w->known || (w->known = expr_eval(&w->expr, regs, w->loads, &w->val)))
+				continue;
+			for (uint32_t j = 0; j < w->expr.num_loads; j++) {
+				struct expr_load *load = &w->loads[j];
+				if (load->state != EXPR_LOAD_WANTED)
+					continue;
+				// a word at 0xffff has no high byte
+				uint32_t len = load->addr + load->size > 0x10000 ? 1 : load->size;
+				ranges[num] = (struct client_mem_range){ load->addr, len };
+				pending[num++] = load;
+			}
+		}
+		if (!num || round == WATCH_MAX_ROUNDS)
+			break;
+
+		if (client_read_mem_batch(ranges, num, batch) == -1)
+			return -1;
+		const uint8_t *p = batch;
+		for (size_t i = 0; i < num; i++) {
+			pending[i]->val = p[0] | (ranges[i].len == 2 ? p[1] << 8 : 0);
+			pending[i]->state = EXPR_LOAD_DONE;
+			p += ranges[i].len;
+		}
+	}
+	return 0;
+}
+
+// the watches go between blank rows below `y`. returns the last of them, or `y` if there are
+// no watches.
+int watch_draw(WINDOW *win, int y) {
+	int max_y, max_x;
+	getmaxyx(win, max_y, max_x);
+
+	for (size_t i = 0; i < num_watches && y+1 < max_y-1; i++) {
+		const struct watch *w = &watches[i];
+		char line[96];
+		y++;
+		wmove(win, y, 1);
+		wclrtoeol(win);
+		if (w->known)
+			snprintf(line, sizeof(line), "%2zu %.*s = %x (%u)", i, WATCH_MAX_TEXT-1, w->text,
+					w->val, w->val);
+		else
+			snprintf(line, sizeof(line), "%2zu %.*s = ?", i, WATCH_MAX_TEXT-1, w->text);
+
+		bool changed = w->known && w->prev_known && w->val != w->prev_val;
+		if (changed)
+			wattron(win, A_REVERSE);
+		mvwaddnstr(win, y, 1, line, max_x-2);
+		if (changed)
+			wattroff(win, A_REVERSE);
+	}
+	if (num_watches && y+1 < max_y-1) {
+		y++;
+		wmove(win, y, 1);
+		wclrtoeol(win);
+	}
+	return y;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2025 Sergio Gómez Del Real
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <ncurses.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WATCH_MAX 64
+#define WATCH_MAX_TEXT 48
+
+int watch_add(const char *text);
+int watch_remove(size_t idx);
+void watch_clear();
+size_t watch_get_count();
+int watch_update(bool stopped);
+int watch_draw(WINDOW *win, int y);
+
+#endif